@@ -0,0 +1,217 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ben {
+namespace bench {
+
+// do_not_optimize forces the compiler to materialize value, so work that only
+// feeds a benchmark result is not removed as dead.
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobber() {
+    asm volatile("" : : : "memory");
+}
+
+// Hardware counters read around each timed run on Linux, through
+// perf_event_open, counting user space only (which perf_event_paranoid 2, the
+// usual default, still allows). Each counter is opened on its own, so one
+// the CPU or the kernel does not offer is reported as "-" without losing the
+// rest. When none can be opened (a container without perf access, another
+// OS, or BEN_BENCH_COUNTERS=0 in the environment) the benchmarks report time
+// only, after one note on stderr. Counters are inherited by threads started
+// after they are opened, so a benchmark that runs its work on threads it
+// starts and joins inside the timed function counts those threads too.
+enum counter_id {
+    counter_cycles,
+    counter_instructions,
+    counter_branch_misses,
+    counter_l1d_misses,
+    counter_llc_misses,
+    counter_count,
+};
+
+struct counter_values {
+    bool valid[counter_count] = {};
+    std::uint64_t value[counter_count] = {};
+};
+
+class counters {
+public:
+    static counters& instance() {
+        static counters c;
+        return c;
+    }
+
+    bool any() const {
+        return any_;
+    }
+
+    void start() {
+#if defined(__linux__)
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    counter_values stop() {
+        counter_values out;
+#if defined(__linux__)
+        for (int i = 0; i < counter_count; i++) {
+            if (fds_[i] >= 0) {
+                ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+        for (int i = 0; i < counter_count; i++) {
+            std::uint64_t v = 0;
+            if (fds_[i] >= 0 && read(fds_[i], &v, sizeof(v)) == static_cast<ssize_t>(sizeof(v))) {
+                out.valid[i] = true;
+                out.value[i] = v;
+            }
+        }
+#endif
+        return out;
+    }
+
+    ~counters() {
+#if defined(__linux__)
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+private:
+    counters() {
+        std::fill(fds_, fds_ + counter_count, -1);
+        const char* env = std::getenv("BEN_BENCH_COUNTERS");
+        if (env != nullptr && std::strcmp(env, "0") == 0) {
+            return;
+        }
+#if defined(__linux__)
+        const std::uint64_t l1d_read_miss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        fds_[counter_cycles] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds_[counter_instructions] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fds_[counter_branch_misses] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        fds_[counter_l1d_misses] = open_counter(PERF_TYPE_HW_CACHE, l1d_read_miss);
+        fds_[counter_llc_misses] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+        any_ = std::any_of(fds_, fds_ + counter_count, [](int fd) { return fd >= 0; });
+        if (!any_) {
+            std::fprintf(stderr, "note: hardware counters unavailable, reporting time only\n");
+        }
+    }
+
+#if defined(__linux__)
+    static int open_counter(std::uint32_t type, std::uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        // Child threads' counts are added to the parent's when they exit.
+        // Inherited counters cannot be read as a group, so each is read
+        // alone, as the single value read_format 0 gives.
+        attr.inherit = 1;
+        attr.read_format = 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+
+    int fds_[counter_count];
+    bool any_ = false;
+};
+
+// The counters of the fastest run of the most recent ns_per_op call, divided
+// by its operation count; report() prints them.
+struct measurement {
+    counter_values totals;
+    std::size_t ops = 0;
+};
+
+inline measurement& last_measurement() {
+    static measurement m;
+    return m;
+}
+
+// ns_per_op runs fn (which performs ops operations) reps times and returns
+// the fastest run in nanoseconds per operation. Taking the minimum filters
+// out scheduler noise, which dominates on short runs.
+template <typename Fn>
+double ns_per_op(Fn&& fn, std::size_t ops, int reps = 5) {
+    using clock = std::chrono::steady_clock;
+    counters& hw = counters::instance();
+    double best = 0;
+    for (int r = 0; r < reps; r++) {
+        hw.start();
+        const auto start = clock::now();
+        fn();
+        const auto stop = clock::now();
+        const counter_values values = hw.stop();
+        const double ns = std::chrono::duration<double, std::nano>(stop - start).count() / static_cast<double>(ops);
+        if (r == 0 || ns < best) {
+            best = ns;
+            last_measurement() = measurement{values, ops};
+        }
+    }
+    return best;
+}
+
+// print_counters ends a report line with the counters of the last
+// measurement, per operation.
+inline void print_counters() {
+    const measurement& m = last_measurement();
+    if (counters::instance().any() && m.ops != 0) {
+        static const char* const labels[counter_count] = {"cyc", "ins", "br-miss", "l1d-miss", "llc-miss"};
+        for (int i = 0; i < counter_count; i++) {
+            if (m.totals.valid[i]) {
+                std::printf(" %10.3f %s", static_cast<double>(m.totals.value[i]) / static_cast<double>(m.ops), labels[i]);
+            } else {
+                std::printf(" %10s %s", "-", labels[i]);
+            }
+        }
+    }
+    std::printf("\n");
+}
+
+inline void report(const char* group, const char* name, double ns) {
+    std::printf("%-28s %-36s %10.3f ns/op", group, name, ns);
+    print_counters();
+}
+
+// report_throughput is report() for operations that each consume
+// bytes_per_op bytes of input; it adds millions of operations and megabytes
+// of input per second.
+inline void report_throughput(const char* group, const char* name, double ns, double bytes_per_op) {
+    std::printf("%-28s %-36s %10.3f ns/op %8.1f Mop/s %8.1f MB/s", group, name, ns, 1e3 / ns, bytes_per_op * 1e3 / ns);
+    print_counters();
+}
+
+} // namespace bench
+} // namespace ben
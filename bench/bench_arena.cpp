@@ -0,0 +1,66 @@
+// Building and tearing down a batch of either<string, vector<char>>, as a
+// per-request parse does: a std::vector of std:: alternatives on the global
+// heap, destroyed element by element, against a ben::arena_batch of pmr
+// alternatives, released in one step without per-element destructors.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "either_arena.hpp"
+
+namespace {
+
+// Both alternatives are longer than the small string buffer, so every
+// element allocates.
+constexpr std::size_t text_len = 40;
+constexpr std::size_t blob_len = 56;
+
+double run_heap(std::size_t n) {
+    using either_t = ben::either<std::string, std::vector<char>>;
+    return ben::bench::ns_per_op([&] {
+        for (int batch = 0; batch < 8; batch++) {
+            std::vector<either_t> v;
+            v.reserve(n);
+            for (std::size_t i = 0; i < n; i++) {
+                if (i % 2 == 0) {
+                    v.emplace_back(std::string(text_len, 't'));
+                } else {
+                    v.emplace_back(std::vector<char>(blob_len, 'b'));
+                }
+            }
+            ben::bench::do_not_optimize(v.data());
+        }
+    }, n * 8);
+}
+
+double run_arena(std::size_t n) {
+    ben::arena_batch<std::pmr::string, std::pmr::vector<char>> batch(n * 128);
+    return ben::bench::ns_per_op([&] {
+        for (int b = 0; b < 8; b++) {
+            batch.reserve(n);
+            for (std::size_t i = 0; i < n; i++) {
+                if (i % 2 == 0) {
+                    batch.emplace_left(text_len, 't');
+                } else {
+                    batch.emplace_right(blob_len, 'b');
+                }
+            }
+            ben::bench::do_not_optimize(batch.begin());
+            batch.clear();
+        }
+    }, n * 8);
+}
+
+} // namespace
+
+int main() {
+    for (const std::size_t n : {std::size_t{1} << 10, std::size_t{1} << 14, std::size_t{1} << 18}) {
+        char group[32];
+        std::snprintf(group, sizeof(group), "%zu elements", n);
+        ben::bench::report(group, "global heap", run_heap(n));
+        ben::bench::report(group, "arena_batch", run_arena(n));
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+// Call-heavy workload returning either<int64_t, rich_error> through a chain of
+// non-inlined functions, with the error stored inline versus out of line via
+// ben::cold. Errors are rare (0% and 1%), so this mostly measures what the
+// fat inline error costs the success path, both when results are consumed
+// immediately and when they are collected into a vector first.
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "either.hpp"
+#include "either_cold.hpp"
+
+namespace {
+
+constexpr std::size_t count = 1 << 16;
+
+struct rich_error {
+    std::string message;
+    std::array<std::int64_t, 8> context;
+};
+
+template <typename result>
+[[gnu::noinline]] result leaf(std::int64_t v) {
+    if (v < 0) {
+        return rich_error{"negative input", {{v}}};
+    }
+    return v + 1;
+}
+
+template <typename result, int depth>
+[[gnu::noinline]] result layer(std::int64_t v) {
+    result r = depth == 0 ? leaf<result>(v) : layer<result, (depth > 0 ? depth - 1 : 0)>(v);
+    if (!r.is_left()) {
+        return r;
+    }
+    return r.as_left() * 3;
+}
+
+template <typename result>
+double run(const std::vector<std::int64_t>& input) {
+    return ben::bench::ns_per_op([&] {
+        std::int64_t sum = 0;
+        for (const auto v : input) {
+            result r = layer<result, 8>(v);
+            sum += r.is_left() ? r.as_left() : r.as_right().context[0];
+        }
+        ben::bench::do_not_optimize(sum);
+    }, input.size());
+}
+
+// Collects every result before consuming them, so the size of the either
+// shows up as memory traffic.
+template <typename result>
+double run_stored(const std::vector<std::int64_t>& input) {
+    std::vector<result> results;
+    results.reserve(input.size());
+    return ben::bench::ns_per_op([&] {
+        results.clear();
+        for (const auto v : input) {
+            results.push_back(layer<result, 2>(v));
+        }
+        std::int64_t sum = 0;
+        for (const auto& r : results) {
+            sum += r.is_left() ? r.as_left() : r.as_right().context[0];
+        }
+        ben::bench::do_not_optimize(sum);
+    }, input.size());
+}
+
+} // namespace
+
+int main() {
+    using inline_t = ben::either<std::int64_t, rich_error>;
+    using cold_t = ben::either<std::int64_t, ben::cold<rich_error>>;
+    std::printf("sizeof inline either %zu, cold either %zu\n", sizeof(inline_t), sizeof(cold_t));
+
+    const double rates[] = {0.0, 0.01};
+    for (const double rate : rates) {
+        std::mt19937_64 rng(3);
+        std::bernoulli_distribution fail(rate);
+        std::vector<std::int64_t> input(count);
+        for (auto& v : input) {
+            v = fail(rng) ? -1 : static_cast<std::int64_t>(rng() % 1000);
+        }
+        char group[32];
+        std::snprintf(group, sizeof(group), "%g%% errors", rate * 100);
+        ben::bench::report(group, "inline rich_error", run<inline_t>(input));
+        ben::bench::report(group, "cold<rich_error>", run<cold_t>(input));
+        ben::bench::report(group, "inline rich_error, stored", run_stored<inline_t>(input));
+        ben::bench::report(group, "cold<rich_error>, stored", run_stored<cold_t>(input));
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+// Error propagation through five call layers, written three ways: a manual
+// `if (!r.is_left()) return r.as_right();` chain, co_either with co_await,
+// and exceptions. Each is run with 0%, 1% and 10% of calls failing at the
+// innermost layer.
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "either.hpp"
+#include "either_coro.hpp"
+
+namespace {
+
+constexpr std::size_t count = 1 << 16;
+
+struct error {
+    int code;
+    std::string context;
+};
+
+using result = ben::either<std::int64_t, error>;
+
+[[gnu::noinline]] result leaf(std::int64_t v) {
+    if (v < 0) {
+        return error{static_cast<int>(v), "value out of range in leaf layer"};
+    }
+    return v * 3;
+}
+
+// Manual chain.
+
+[[gnu::noinline]] result manual_layer1(std::int64_t v) {
+    result r = leaf(v);
+    if (!r.is_left()) {
+        return std::move(r.right_ref());
+    }
+    return r.as_left() + 1;
+}
+
+#define MANUAL_LAYER(name, inner)                      \
+    [[gnu::noinline]] result name(std::int64_t v) {    \
+        result r = inner(v);                           \
+        if (!r.is_left()) {                            \
+            return std::move(r.right_ref());           \
+        }                                              \
+        return r.as_left() + 1;                        \
+    }
+
+MANUAL_LAYER(manual_layer2, manual_layer1)
+MANUAL_LAYER(manual_layer3, manual_layer2)
+MANUAL_LAYER(manual_layer4, manual_layer3)
+MANUAL_LAYER(manual_layer5, manual_layer4)
+
+// Coroutines.
+
+[[gnu::noinline]] ben::co_either<std::int64_t, error> coro_layer1(std::int64_t v) {
+    co_return co_await leaf(v) + 1;
+}
+
+#define CORO_LAYER(name, inner)                                                 \
+    [[gnu::noinline]] ben::co_either<std::int64_t, error> name(std::int64_t v) { \
+        co_return co_await inner(v) + 1;                                        \
+    }
+
+CORO_LAYER(coro_layer2, coro_layer1)
+CORO_LAYER(coro_layer3, coro_layer2)
+CORO_LAYER(coro_layer4, coro_layer3)
+CORO_LAYER(coro_layer5, coro_layer4)
+
+// Exceptions.
+
+struct error_exception {
+    error e;
+};
+
+[[gnu::noinline]] std::int64_t throwing_leaf(std::int64_t v) {
+    if (v < 0) {
+        throw error_exception{error{static_cast<int>(v), "value out of range in leaf layer"}};
+    }
+    return v * 3;
+}
+
+#define THROW_LAYER(name, inner)                             \
+    [[gnu::noinline]] std::int64_t name(std::int64_t v) {    \
+        return inner(v) + 1;                                 \
+    }
+
+THROW_LAYER(throw_layer1, throwing_leaf)
+THROW_LAYER(throw_layer2, throw_layer1)
+THROW_LAYER(throw_layer3, throw_layer2)
+THROW_LAYER(throw_layer4, throw_layer3)
+THROW_LAYER(throw_layer5, throw_layer4)
+
+std::vector<std::int64_t> make_input(double error_rate) {
+    std::mt19937_64 rng(7);
+    std::bernoulli_distribution fail(error_rate);
+    std::vector<std::int64_t> out(count);
+    for (auto& v : out) {
+        v = fail(rng) ? -1 : static_cast<std::int64_t>(rng() % 1000);
+    }
+    return out;
+}
+
+} // namespace
+
+int main() {
+    const double rates[] = {0.0, 0.01, 0.1};
+    for (const double rate : rates) {
+        const auto input = make_input(rate);
+        char group[32];
+        std::snprintf(group, sizeof(group), "%g%% errors", rate * 100);
+
+        ben::bench::report(group, "manual is_left chain", ben::bench::ns_per_op([&] {
+            std::int64_t sum = 0;
+            for (const auto v : input) {
+                result r = manual_layer5(v);
+                sum += r.is_left() ? r.as_left() : r.as_right().code;
+            }
+            ben::bench::do_not_optimize(sum);
+        }, input.size()));
+
+        ben::bench::report(group, "co_either co_await", ben::bench::ns_per_op([&] {
+            std::int64_t sum = 0;
+            for (const auto v : input) {
+                result r = coro_layer5(v);
+                sum += r.is_left() ? r.as_left() : r.as_right().code;
+            }
+            ben::bench::do_not_optimize(sum);
+        }, input.size()));
+
+        ben::bench::report(group, "exceptions", ben::bench::ns_per_op([&] {
+            std::int64_t sum = 0;
+            for (const auto v : input) {
+                try {
+                    sum += throw_layer5(v);
+                } catch (const error_exception& e) {
+                    sum += e.e.code;
+                }
+            }
+            ben::bench::do_not_optimize(sum);
+        }, input.size()));
+    }
+    if (ben::detail::frame_pool::heap_allocations() != 0) {
+        std::printf("co_either frames fell back to the heap %zu times\n", ben::detail::frame_pool::heap_allocations());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+// JSON string unescaping, the case ben::cow is made for: most strings in real
+// documents contain no escapes and can be returned as a view of the input,
+// while a few have to be decoded into a new string. The same unescaper
+// returns std::string always, or ben::cow<std::string>, and each is run with
+// 0%, 10% and 100% of the strings containing an escape.
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench.hpp"
+#include "either_cow.hpp"
+
+namespace {
+
+constexpr std::size_t string_count = 200000;
+
+// Decodes the escapes in s (\" \\ \/ \b \f \n \r \t; \u escapes are copied
+// through, which is enough for the benchmark) onto out, starting at the first
+// backslash, which the caller has found.
+void unescape_from(std::string_view s, std::size_t first, std::string& out) {
+    out.reserve(s.size());
+    out.append(s.data(), first);
+    for (std::size_t i = first; i < s.size(); i++) {
+        if (s[i] != '\\' || i + 1 == s.size()) {
+            out.push_back(s[i]);
+            continue;
+        }
+        const char c = s[++i];
+        switch (c) {
+        case 'b': out.push_back('\b'); break;
+        case 'f': out.push_back('\f'); break;
+        case 'n': out.push_back('\n'); break;
+        case 'r': out.push_back('\r'); break;
+        case 't': out.push_back('\t'); break;
+        default: out.push_back(c); break;
+        }
+    }
+}
+
+[[gnu::noinline]] std::string unescape_string(std::string_view s) {
+    const std::size_t first = s.find('\\');
+    if (first == std::string_view::npos) {
+        return std::string(s);
+    }
+    std::string out;
+    unescape_from(s, first, out);
+    return out;
+}
+
+[[gnu::noinline]] ben::cow<std::string> unescape_cow(std::string_view s) {
+    const std::size_t first = s.find('\\');
+    if (first == std::string_view::npos) {
+        return s;
+    }
+    std::string out;
+    unescape_from(s, first, out);
+    return ben::cow<std::string>(std::move(out));
+}
+
+// Strings of 8 to 48 characters, the range of typical JSON keys and short
+// values; lengths over 15 do not fit libstdc++'s small string buffer.
+std::vector<std::string> make_strings(int escaped_percent) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> len(8, 48);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::vector<std::string> out;
+    out.reserve(string_count);
+    for (std::size_t i = 0; i < string_count; i++) {
+        std::string s;
+        const int n = len(rng);
+        for (int j = 0; j < n; j++) {
+            s.push_back(static_cast<char>(letter(rng)));
+        }
+        if (percent(rng) < escaped_percent) {
+            s.insert(s.size() / 2, "\\n");
+        }
+        out.push_back(std::move(s));
+    }
+    return out;
+}
+
+template <typename Unescape>
+double run(const std::vector<std::string>& strings, Unescape&& unescape) {
+    return ben::bench::ns_per_op([&] {
+        std::size_t total = 0;
+        for (const std::string& s : strings) {
+            const auto r = unescape(std::string_view(s));
+            total += std::string_view(r).size();
+        }
+        ben::bench::do_not_optimize(total);
+    }, strings.size());
+}
+
+} // namespace
+
+int main() {
+    for (const int escaped : {0, 10, 100}) {
+        const std::vector<std::string> strings = make_strings(escaped);
+        char group[32];
+        std::snprintf(group, sizeof(group), "%d%% escaped", escaped);
+        ben::bench::report(group, "std::string", run(strings, unescape_string));
+        ben::bench::report(group, "ben::cow<std::string>", run(strings, unescape_cow));
+    }
+    return 0;
+}
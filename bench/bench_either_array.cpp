@@ -0,0 +1,78 @@
+// Worker threads each bumping a counter in their own element of an array of
+// either<counter_state, error>: a std::vector, whose neighbouring elements
+// share cache lines, against ben::either_array with one element per line,
+// with and without the errors moved to a cold side table, and the split
+// layout packed, where the hot slots are small enough to share lines again.
+
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "either_array.hpp"
+
+namespace {
+
+struct counter_state {
+    std::uint64_t count;
+};
+
+struct error {
+    int code;
+    char message[36];
+};
+
+using either_t = ben::either<counter_state, error>;
+
+constexpr int updates = 1 << 20;
+
+// Each worker stores its count back to memory on every update, as a shared
+// statistics block would, so the line holding the element bounces between
+// cores whenever it is shared.
+template <typename Bump>
+double run(std::size_t threads, Bump bump) {
+    return ben::bench::ns_per_op([&] {
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < threads; t++) {
+            workers.emplace_back([&bump, t] {
+                for (int i = 0; i < updates; i++) {
+                    bump(t);
+                    ben::bench::clobber();
+                }
+            });
+        }
+        for (std::thread& w : workers) {
+            w.join();
+        }
+    }, threads * updates, 3);
+}
+
+double run_vector(std::size_t threads) {
+    std::vector<either_t> v(threads, either_t(counter_state{0}));
+    return run(threads, [&v](std::size_t t) { v[t].left_ref().count++; });
+}
+
+template <std::size_t slot_align, ben::either_split split>
+double run_array(std::size_t threads) {
+    ben::either_array<counter_state, error, slot_align, split> arr(threads, either_t(counter_state{0}));
+    return run(threads, [&arr](std::size_t t) { arr.left(t).count++; });
+}
+
+} // namespace
+
+int main() {
+    std::printf("sizeof either %zu, cache line %zu\n", sizeof(either_t), ben::cache_line_size);
+    for (const std::size_t threads : {std::size_t{1}, std::size_t{2}, std::size_t{4}, std::size_t{8}}) {
+        char group[32];
+        std::snprintf(group, sizeof(group), "%zu threads", threads);
+        ben::bench::report(group, "std::vector<either>", run_vector(threads));
+        ben::bench::report(group, "either_array, padded",
+                           run_array<ben::cache_line_size, ben::either_split::none>(threads));
+        ben::bench::report(group, "either_array, padded, cold split",
+                           run_array<ben::cache_line_size, ben::either_split::cold_right>(threads));
+        ben::bench::report(group, "either_array, packed, cold split",
+                           run_array<alignof(counter_state), ben::either_split::cold_right>(threads));
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+// Comparing two snapshots of an array of eithers to detect a change, as a
+// poller does: std::equal, which calls either's operator== on each element,
+// against ben::equal and ben::mismatch on an either opted into
+// zero_either_padding, which compare the arrays as bytes.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "bench.hpp"
+#include "either_algorithm.hpp"
+
+namespace {
+
+struct reading {
+    std::int32_t value;
+
+    bool operator==(const reading& other) const {
+        return value == other.value;
+    }
+};
+
+} // namespace
+
+namespace ben {
+template <>
+struct zero_either_padding<reading, char> : std::true_type {};
+} // namespace ben
+
+namespace {
+
+using either_t = ben::either<reading, char>;
+
+std::vector<either_t> make(std::size_t n) {
+    std::vector<either_t> v;
+    v.reserve(n);
+    std::uint32_t x = 2463534242u;
+    for (std::size_t i = 0; i < n; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        if (x % 4 == 0) {
+            v.emplace_back(static_cast<char>(x >> 8));
+        } else {
+            v.emplace_back(reading{static_cast<std::int32_t>(x)});
+        }
+    }
+    return v;
+}
+
+} // namespace
+
+int main() {
+    for (const std::size_t n : {std::size_t{1} << 10, std::size_t{1} << 16, std::size_t{1} << 20}) {
+        const std::vector<either_t> a = make(n);
+        std::vector<either_t> b = a;
+        const std::size_t reps = (std::size_t{1} << 24) / n;
+        char group[32];
+
+        std::snprintf(group, sizeof(group), "%zu equal", n);
+        ben::bench::report(group, "std::equal", ben::bench::ns_per_op([&] {
+            for (std::size_t r = 0; r < reps; r++) {
+                ben::bench::do_not_optimize(std::equal(a.begin(), a.end(), b.begin()));
+                ben::bench::clobber();
+            }
+        }, reps * n));
+        ben::bench::report(group, "ben::equal", ben::bench::ns_per_op([&] {
+            for (std::size_t r = 0; r < reps; r++) {
+                ben::bench::do_not_optimize(ben::equal(a.data(), b.data(), n));
+                ben::bench::clobber();
+            }
+        }, reps * n));
+
+        // A change near the end, so the search runs through almost all of it.
+        b[n - n / 16] = 'z';
+        std::snprintf(group, sizeof(group), "%zu mismatch", n);
+        ben::bench::report(group, "std::mismatch", ben::bench::ns_per_op([&] {
+            for (std::size_t r = 0; r < reps; r++) {
+                ben::bench::do_not_optimize(std::mismatch(a.begin(), a.end(), b.begin()).first);
+                ben::bench::clobber();
+            }
+        }, reps * n));
+        ben::bench::report(group, "ben::mismatch", ben::bench::ns_per_op([&] {
+            for (std::size_t r = 0; r < reps; r++) {
+                ben::bench::do_not_optimize(ben::mismatch(a.data(), b.data(), n));
+                ben::bench::clobber();
+            }
+        }, reps * n));
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+// Cost of converting eithers to the standard sum types and back. For
+// trivially copyable alternatives each conversion should cost the same as
+// copying the either itself. For std::string alternatives, the moving
+// conversions are compared with the branch-copy-rebuild code they replace.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "bench.hpp"
+#include "either_std.hpp"
+
+namespace {
+
+constexpr std::size_t count = 1 << 16;
+
+using small_t = ben::either<std::int64_t, int>;
+using string_t = ben::either<std::string, int>;
+
+std::vector<small_t> make_small() {
+    std::vector<small_t> v;
+    v.reserve(count);
+    for (std::size_t i = 0; i < count; i++) {
+        if (i % 3 == 0) {
+            v.emplace_back(static_cast<int>(i));
+        } else {
+            v.emplace_back(static_cast<std::int64_t>(i));
+        }
+    }
+    return v;
+}
+
+std::vector<string_t> make_strings() {
+    std::vector<string_t> v;
+    v.reserve(count);
+    for (std::size_t i = 0; i < count; i++) {
+        if (i % 3 == 0) {
+            v.emplace_back(static_cast<int>(i));
+        } else {
+            v.emplace_back(std::string(40, static_cast<char>('a' + i % 26)));
+        }
+    }
+    return v;
+}
+
+template <typename Convert>
+double run_small(const std::vector<small_t>& in, Convert&& convert) {
+    return ben::bench::ns_per_op([&] {
+        std::int64_t sum = 0;
+        for (const small_t& e : in) {
+            sum += convert(e);
+        }
+        ben::bench::do_not_optimize(sum);
+    }, in.size());
+}
+
+// Each pass converts a fresh copy of the strings, so the copy is made outside
+// the timed region and only the conversion is measured.
+template <typename Convert>
+double run_strings(const std::vector<string_t>& in, Convert&& convert) {
+    double best = 0;
+    for (int r = 0; r < 5; r++) {
+        std::vector<string_t> work = in;
+        std::vector<std::variant<std::string, int>> out;
+        out.reserve(work.size());
+        const double ns = ben::bench::ns_per_op([&] {
+            for (string_t& e : work) {
+                out.push_back(convert(e));
+            }
+            ben::bench::clobber();
+        }, work.size(), 1);
+        best = r == 0 ? ns : std::min(best, ns);
+    }
+    return best;
+}
+
+} // namespace
+
+int main() {
+    const std::vector<small_t> small = make_small();
+    ben::bench::report("either<int64_t, int>", "copy either", run_small(small, [](const small_t& e) {
+        const small_t copy = e;
+        return copy.value_or(-1);
+    }));
+    ben::bench::report("either<int64_t, int>", "variant round trip", run_small(small, [](const small_t& e) {
+        return ben::from_variant(ben::to_variant(e)).value_or(-1);
+    }));
+    ben::bench::report("either<int64_t, int>", "optional round trip", run_small(small, [](const small_t& e) {
+        return ben::from_optional<int>(ben::to_optional(e), 0).value_or(-1);
+    }));
+#if defined(__cpp_lib_expected)
+    ben::bench::report("either<int64_t, int>", "expected round trip", run_small(small, [](const small_t& e) {
+        return ben::from_expected(ben::to_expected(e)).value_or(-1);
+    }));
+#endif
+
+    const std::vector<string_t> strings = make_strings();
+    ben::bench::report("either<string, int>", "branch, copy, rebuild", run_strings(strings, [](string_t& e) {
+        if (e.is_left()) {
+            return std::variant<std::string, int>(std::in_place_index<0>, e.as_left());
+        }
+        return std::variant<std::string, int>(std::in_place_index<1>, e.as_right());
+    }));
+    ben::bench::report("either<string, int>", "to_variant(move)", run_strings(strings, [](string_t& e) {
+        return ben::to_variant(std::move(e));
+    }));
+    return 0;
+}
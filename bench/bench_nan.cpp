@@ -0,0 +1,70 @@
+// Numeric columns of either<double, uint32_t> (16 bytes per value) against
+// nan_either<double, uint32_t> (8 bytes), with 10% of the entries holding a
+// handle. Each column is scanned to count and sum the lefts, once fitting in
+// cache and once well beyond it.
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "bench.hpp"
+#include "either.hpp"
+#include "either_nan.hpp"
+
+namespace {
+
+template <typename E>
+std::vector<E> make_column(std::size_t n) {
+    std::mt19937_64 rng(5);
+    std::uniform_real_distribution<double> value(-1e6, 1e6);
+    std::vector<E> out;
+    out.reserve(n);
+    for (std::size_t i = 0; i < n; i++) {
+        if (rng() % 10 == 0) {
+            out.emplace_back(static_cast<std::uint32_t>(i));
+        } else {
+            out.emplace_back(value(rng));
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+int main() {
+    using wide_t = ben::either<double, std::uint32_t>;
+    using boxed_t = ben::nan_either<double, std::uint32_t>;
+    std::printf("sizeof either %zu, nan_either %zu\n", sizeof(wide_t), sizeof(boxed_t));
+
+    const std::size_t sizes[] = {1 << 12, 1 << 23};
+    for (const std::size_t n : sizes) {
+        const auto wide = make_column<wide_t>(n);
+        const auto boxed = make_column<boxed_t>(n);
+        char group[32];
+        std::snprintf(group, sizeof(group), "%zu values", n);
+
+        ben::bench::report(group, "either sum of lefts", ben::bench::ns_per_op([&] {
+            double sum = 0;
+            for (const auto& e : wide) {
+                sum += e.is_left() ? e.as_left() : 0.0;
+            }
+            ben::bench::do_not_optimize(sum);
+        }, n));
+        ben::bench::report(group, "nan_either sum of lefts", ben::bench::ns_per_op([&] {
+            ben::bench::do_not_optimize(ben::sum_left(boxed.data(), n));
+        }, n));
+
+        ben::bench::report(group, "either count of lefts", ben::bench::ns_per_op([&] {
+            std::size_t count = 0;
+            for (const auto& e : wide) {
+                count += e.is_left() ? 1 : 0;
+            }
+            ben::bench::do_not_optimize(count);
+        }, n));
+        ben::bench::report(group, "nan_either count of lefts", ben::bench::ns_per_op([&] {
+            ben::bench::do_not_optimize(ben::count_left(boxed.data(), n));
+        }, n));
+    }
+    return 0;
+}
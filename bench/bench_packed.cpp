@@ -0,0 +1,87 @@
+// The memory against access-speed trade of packed_either: summing the lefts
+// of an array of either<std::uint8_t, std::uint64_t> (16 bytes each) against
+// the same values as packed_either (9 bytes each), at sizes that fit in L1,
+// in L2 and in neither; and the cost of converting a packed array to an
+// aligned one, element by element against ben::unpack.
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "bench.hpp"
+#include "either_packed.hpp"
+
+namespace {
+
+using either_t = ben::either<std::uint8_t, std::uint64_t>;
+using packed_t = ben::packed_either<std::uint8_t, std::uint64_t>;
+
+std::vector<either_t> make(std::size_t n) {
+    std::vector<either_t> v;
+    v.reserve(n);
+    std::uint64_t x = 88172645463325252ull;
+    for (std::size_t i = 0; i < n; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        if (x % 8 == 0) {
+            v.emplace_back(static_cast<std::uint8_t>(x));
+        } else {
+            v.emplace_back(x);
+        }
+    }
+    return v;
+}
+
+} // namespace
+
+int main() {
+    std::printf("sizeof either %zu, packed_either %zu\n", sizeof(either_t), sizeof(packed_t));
+    for (const std::size_t n : {std::size_t{1} << 10, std::size_t{1} << 14, std::size_t{1} << 22}) {
+        const std::vector<either_t> aligned = make(n);
+        std::vector<packed_t> packed(n, packed_t(std::uint8_t{0}));
+        ben::pack(aligned.data(), n, packed.data());
+        const std::size_t reps = (std::size_t{1} << 24) / n;
+        char group[48];
+
+        std::snprintf(group, sizeof(group), "%zu elements, sum", n);
+        ben::bench::report(group, "either", ben::bench::ns_per_op([&] {
+            for (std::size_t r = 0; r < reps; r++) {
+                std::uint64_t sum = 0;
+                for (const either_t& e : aligned) {
+                    sum += e.is_left() ? e.as_left() : e.as_right();
+                }
+                ben::bench::do_not_optimize(sum);
+            }
+        }, reps * n));
+        ben::bench::report(group, "packed_either", ben::bench::ns_per_op([&] {
+            for (std::size_t r = 0; r < reps; r++) {
+                std::uint64_t sum = 0;
+                for (const packed_t& e : packed) {
+                    sum += e.is_left() ? e.left() : e.right();
+                }
+                ben::bench::do_not_optimize(sum);
+            }
+        }, reps * n));
+
+        std::vector<either_t> out(n, either_t(std::uint8_t{0}));
+        std::snprintf(group, sizeof(group), "%zu elements, unpack", n);
+        ben::bench::report(group, "to_either loop", ben::bench::ns_per_op([&] {
+            for (std::size_t r = 0; r < reps; r++) {
+                for (std::size_t i = 0; i < n; i++) {
+                    out[i] = packed[i].to_either();
+                }
+                ben::bench::do_not_optimize(out.data());
+                ben::bench::clobber();
+            }
+        }, reps * n));
+        ben::bench::report(group, "ben::unpack", ben::bench::ns_per_op([&] {
+            for (std::size_t r = 0; r < reps; r++) {
+                ben::unpack(packed.data(), n, out.data());
+                ben::bench::do_not_optimize(out.data());
+                ben::bench::clobber();
+            }
+        }, reps * n));
+    }
+    return 0;
+}
@@ -0,0 +1,248 @@
+// End-to-end parsing benchmark: a comma separated stream of signed decimal
+// integers, generated locally, parsed token by token. The same parser is
+// written five ways (ben::either, exceptions, error codes, std::variant and
+// std::optional) and each is run with 0%, 1% and 50% of the tokens malformed.
+// Each is reported in nanoseconds per token, millions of tokens and megabytes
+// of input per second, and hardware counters per token.
+
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <string>
+#include <variant>
+
+#include "bench.hpp"
+#include "either.hpp"
+
+namespace {
+
+constexpr std::size_t token_count = 2000000;
+
+enum class parse_errc : std::uint8_t {
+    ok,
+    empty,
+    bad_digit,
+    overflow,
+};
+
+struct parse_error {
+    parse_errc code;
+    std::size_t offset;
+};
+
+// input is a cursor over the text; every parser consumes one token and the
+// comma after it, whether or not the token was valid.
+struct input {
+    const char* p;
+    const char* end;
+};
+
+const char* skip_token(const char* p, const char* end) {
+    while (p != end && *p != ',') {
+        p++;
+    }
+    return p == end ? p : p + 1;
+}
+
+// The shared core: parses one token, returning ok and storing the value, or
+// an error code. Each variant below wraps this in its own error channel.
+inline parse_errc parse_core(input& in, std::int64_t& out) {
+    const char* p = in.p;
+    bool neg = false;
+    if (p != in.end && *p == '-') {
+        neg = true;
+        p++;
+    }
+    if (p == in.end || *p == ',') {
+        in.p = skip_token(p, in.end);
+        return parse_errc::empty;
+    }
+    std::uint64_t v = 0;
+    for (; p != in.end && *p != ','; p++) {
+        const unsigned d = static_cast<unsigned>(*p - '0');
+        if (d > 9) {
+            in.p = skip_token(p, in.end);
+            return parse_errc::bad_digit;
+        }
+        if (v > (UINT64_MAX - d) / 10 || v * 10 + d > static_cast<std::uint64_t>(INT64_MAX)) {
+            in.p = skip_token(p, in.end);
+            return parse_errc::overflow;
+        }
+        v = v * 10 + d;
+    }
+    in.p = p == in.end ? p : p + 1;
+    out = neg ? -static_cast<std::int64_t>(v) : static_cast<std::int64_t>(v);
+    return parse_errc::ok;
+}
+
+[[gnu::noinline]] ben::either<std::int64_t, parse_error> parse_either(input& in, const char* base) {
+    const std::size_t offset = static_cast<std::size_t>(in.p - base);
+    std::int64_t v = 0;
+    const parse_errc e = parse_core(in, v);
+    if (e != parse_errc::ok) {
+        return parse_error{e, offset};
+    }
+    return v;
+}
+
+struct parse_exception {
+    parse_error error;
+};
+
+[[gnu::noinline]] std::int64_t parse_throwing(input& in, const char* base) {
+    const std::size_t offset = static_cast<std::size_t>(in.p - base);
+    std::int64_t v = 0;
+    const parse_errc e = parse_core(in, v);
+    if (e != parse_errc::ok) {
+        throw parse_exception{parse_error{e, offset}};
+    }
+    return v;
+}
+
+[[gnu::noinline]] parse_errc parse_code(input& in, const char* base, std::int64_t& out, parse_error& err) {
+    const std::size_t offset = static_cast<std::size_t>(in.p - base);
+    const parse_errc e = parse_core(in, out);
+    if (e != parse_errc::ok) {
+        err = parse_error{e, offset};
+    }
+    return e;
+}
+
+[[gnu::noinline]] std::variant<std::int64_t, parse_error> parse_variant(input& in, const char* base) {
+    const std::size_t offset = static_cast<std::size_t>(in.p - base);
+    std::int64_t v = 0;
+    const parse_errc e = parse_core(in, v);
+    if (e != parse_errc::ok) {
+        return parse_error{e, offset};
+    }
+    return v;
+}
+
+// std::optional has no error channel; a failed token just yields nullopt.
+[[gnu::noinline]] std::optional<std::int64_t> parse_optional(input& in) {
+    std::int64_t v = 0;
+    if (parse_core(in, v) != parse_errc::ok) {
+        return std::nullopt;
+    }
+    return v;
+}
+
+std::string make_text(double error_rate) {
+    std::mt19937_64 rng(11);
+    std::bernoulli_distribution bad(error_rate);
+    std::uniform_int_distribution<std::int64_t> value(-1000000000, 1000000000);
+    std::string text;
+    text.reserve(token_count * 12);
+    for (std::size_t i = 0; i < token_count; i++) {
+        if (i != 0) {
+            text += ',';
+        }
+        std::string token = std::to_string(value(rng));
+        if (bad(rng)) {
+            token[token.size() / 2] = 'x';
+        }
+        text += token;
+    }
+    return text;
+}
+
+// Every variant folds values (and, where it has them, error offsets) into a
+// checksum so none of the parsing work can be discarded.
+struct totals {
+    std::int64_t sum = 0;
+    std::size_t errors = 0;
+};
+
+template <typename Fn>
+totals run(const char* group, const char* name, const std::string& text, Fn&& parse_all) {
+    totals t;
+    const double ns = ben::bench::ns_per_op([&] {
+        t = parse_all(input{text.data(), text.data() + text.size()});
+        ben::bench::do_not_optimize(t);
+    }, token_count, 3);
+    ben::bench::report_throughput(group, name, ns, static_cast<double>(text.size()) / token_count);
+    return t;
+}
+
+} // namespace
+
+int main() {
+    const double rates[] = {0.0, 0.01, 0.5};
+    for (const double rate : rates) {
+        const std::string text = make_text(rate);
+        const char* base = text.data();
+        char group[32];
+        std::snprintf(group, sizeof(group), "%g%% errors", rate * 100);
+
+        run(group, "ben::either", text, [base](input in) {
+            totals t;
+            while (in.p != in.end) {
+                const auto r = parse_either(in, base);
+                if (r.is_left()) {
+                    t.sum += r.as_left();
+                } else {
+                    t.errors++;
+                    t.sum += static_cast<std::int64_t>(r.as_right().offset);
+                }
+            }
+            return t;
+        });
+
+        run(group, "exceptions", text, [base](input in) {
+            totals t;
+            while (in.p != in.end) {
+                try {
+                    t.sum += parse_throwing(in, base);
+                } catch (const parse_exception& e) {
+                    t.errors++;
+                    t.sum += static_cast<std::int64_t>(e.error.offset);
+                }
+            }
+            return t;
+        });
+
+        run(group, "error codes", text, [base](input in) {
+            totals t;
+            while (in.p != in.end) {
+                std::int64_t v = 0;
+                parse_error err{};
+                if (parse_code(in, base, v, err) == parse_errc::ok) {
+                    t.sum += v;
+                } else {
+                    t.errors++;
+                    t.sum += static_cast<std::int64_t>(err.offset);
+                }
+            }
+            return t;
+        });
+
+        run(group, "std::variant", text, [base](input in) {
+            totals t;
+            while (in.p != in.end) {
+                const auto r = parse_variant(in, base);
+                if (const auto* v = std::get_if<std::int64_t>(&r)) {
+                    t.sum += *v;
+                } else {
+                    t.errors++;
+                    t.sum += static_cast<std::int64_t>(std::get<parse_error>(r).offset);
+                }
+            }
+            return t;
+        });
+
+        run(group, "std::optional", text, [](input in) {
+            totals t;
+            while (in.p != in.end) {
+                const auto r = parse_optional(in);
+                if (r) {
+                    t.sum += *r;
+                } else {
+                    t.errors++;
+                }
+            }
+            return t;
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+// Cost of moving a buffer of either<unique_ptr<char[]>, array<char, 10>> to
+// new storage, as vector growth does: move construct plus destroy per
+// element, against ben::uninitialized_relocate, which is one memcpy for
+// trivially relocatable eithers.
+
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "bench.hpp"
+#include "either.hpp"
+#include "either_relocate.hpp"
+
+namespace {
+
+using slow_t = std::unique_ptr<char[]>;
+using fast_t = std::array<char, 10>;
+using either_t = ben::either<slow_t, fast_t>;
+
+static_assert(ben::is_trivially_relocatable<either_t>::value, "expected a trivially relocatable either");
+
+struct buffer {
+    explicit buffer(std::size_t n)
+        : data(static_cast<either_t*>(::operator new(n * sizeof(either_t)))), size(n) {}
+    ~buffer() {
+        ::operator delete(data);
+    }
+    either_t* data;
+    std::size_t size;
+};
+
+void move_and_destroy(either_t* first, either_t* last, either_t* d) {
+    for (; first != last; ++first, ++d) {
+        ::new (static_cast<void*>(d)) either_t(std::move(*first));
+        first->~either_t();
+    }
+}
+
+template <typename Relocate>
+double run(std::size_t n, Relocate&& relocate) {
+    buffer a(n);
+    buffer b(n);
+    for (std::size_t i = 0; i < n; i++) {
+        if (i % 4 == 0) {
+            ::new (&a.data[i]) either_t(slow_t(new char[8]));
+        } else {
+            ::new (&a.data[i]) either_t(fast_t{});
+        }
+    }
+    // Bounce the elements between the two buffers; each pass is one
+    // reallocation's worth of relocation.
+    bool in_a = true;
+    const double ns = ben::bench::ns_per_op([&] {
+        for (int pass = 0; pass < 8; pass++) {
+            either_t* from = in_a ? a.data : b.data;
+            either_t* to = in_a ? b.data : a.data;
+            relocate(from, from + n, to);
+            in_a = !in_a;
+            ben::bench::clobber();
+        }
+    }, n * 8);
+    either_t* live = in_a ? a.data : b.data;
+    for (std::size_t i = 0; i < n; i++) {
+        live[i].~either_t();
+    }
+    return ns;
+}
+
+} // namespace
+
+int main() {
+    const std::size_t sizes[] = {1 << 10, 1 << 14, 1 << 18, 1 << 21};
+    for (const std::size_t n : sizes) {
+        char group[32];
+        std::snprintf(group, sizeof(group), "%zu elements", n);
+        ben::bench::report(group, "move + destroy", run(n, move_and_destroy));
+        ben::bench::report(group, "uninitialized_relocate", run(n, [](either_t* f, either_t* l, either_t* d) {
+            ben::uninitialized_relocate(f, l, d);
+        }));
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+// A chain of continuations, each taking the previous stage's result and
+// producing the next, built with std::promise/std::future (one shared state
+// allocated per stage) and with ben::task_result, which lives in the caller's
+// frame and is driven by a local_executor. std::future has no then(), so each
+// stage there is set_value followed by get(), the cheapest single-threaded
+// use it allows.
+
+#include <cstdio>
+#include <future>
+#include <new>
+#include <string>
+
+#include "bench.hpp"
+#include "either_task.hpp"
+
+namespace {
+
+constexpr int chain_depth = 8;
+constexpr int chains = 100000;
+
+int promise_chain(int seed) {
+    int v = seed;
+    for (int i = 0; i < chain_depth; i++) {
+        std::promise<int> p;
+        std::future<int> f = p.get_future();
+        p.set_value(v + 1);
+        v = f.get();
+    }
+    return v;
+}
+
+using result_t = ben::task_result<int, std::string>;
+
+struct stage {
+    result_t* from;
+    result_t* to;
+    void operator()() const {
+        const result_t::result_type& r = from->get();
+        if (r.is_left()) {
+            to->set_value(r.as_left() + 1);
+        } else {
+            to->set_error(r.as_right());
+        }
+    }
+};
+
+int task_chain(ben::local_executor& ex, int seed) {
+    // The results and their continuations live in this frame.
+    alignas(result_t) unsigned char storage[sizeof(result_t) * (chain_depth + 1)];
+    result_t* results = reinterpret_cast<result_t*>(storage);
+    for (int i = 0; i <= chain_depth; i++) {
+        ::new (&results[i]) result_t(ex);
+    }
+    alignas(ben::callback<stage>) unsigned char cb_storage[sizeof(ben::callback<stage>) * chain_depth];
+    ben::callback<stage>* callbacks = reinterpret_cast<ben::callback<stage>*>(cb_storage);
+    for (int i = 0; i < chain_depth; i++) {
+        ::new (&callbacks[i]) ben::callback<stage>(stage{&results[i], &results[i + 1]});
+        results[i].then(callbacks[i]);
+    }
+    results[0].set_value(seed);
+    ex.run();
+    const int v = results[chain_depth].get().as_left();
+    for (int i = 0; i < chain_depth; i++) {
+        callbacks[i].~callback();
+    }
+    for (int i = 0; i <= chain_depth; i++) {
+        results[i].~result_t();
+    }
+    return v;
+}
+
+} // namespace
+
+int main() {
+    char group[32];
+    std::snprintf(group, sizeof(group), "chain of %d", chain_depth);
+    ben::bench::report(group, "std::promise/std::future", ben::bench::ns_per_op([] {
+        int sum = 0;
+        for (int c = 0; c < chains; c++) {
+            sum += promise_chain(c);
+        }
+        ben::bench::do_not_optimize(sum);
+    }, chains));
+    ben::local_executor ex;
+    ben::bench::report(group, "ben::task_result", ben::bench::ns_per_op([&] {
+        int sum = 0;
+        for (int c = 0; c < chains; c++) {
+            sum += task_chain(ex, c);
+        }
+        ben::bench::do_not_optimize(sum);
+    }, chains));
+    return 0;
+}
@@ -0,0 +1,149 @@
+#!/bin/sh
+# Usage: compile_time.sh [compiler flags...]
+# Measures what either costs the compiler:
+#  - the preprocessed size of either.hpp, which must stay within
+#    HEADER_BUDGET lines as C++14 and HEADER_BUDGET_CPP20 as C++20 (whose
+#    standard headers are larger, and which adds std::construct_at);
+#  - the time to compile, and the object size of, a file that instantiates
+#    and uses COUNT distinct eithers;
+#  - the same for a file using the pairs in either_common.hpp, with and
+#    without their explicit instantiations declared extern.
+# Times are the best of three runs, in milliseconds.
+set -e
+CXX=${CXX:-c++}
+COUNT=${COUNT:-100}
+HEADER_BUDGET=${HEADER_BUDGET:-6000}
+HEADER_BUDGET_CPP20=${HEADER_BUDGET_CPP20:-12000}
+here=$(cd "$(dirname "$0")/.." && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+now_ms() {
+    date +%s%3N
+}
+
+# best_ms <command...> prints the fastest of three runs of the command.
+best_ms() {
+    best=
+    for _ in 1 2 3; do
+        start=$(now_ms)
+        "$@"
+        took=$(($(now_ms) - start))
+        if [ -z "$best" ] || [ "$took" -lt "$best" ]; then
+            best=$took
+        fi
+    done
+    echo "$best"
+}
+
+report() {
+    printf '%-44s %8s ms %10s bytes\n' "$1" "$2" "$3"
+}
+
+for std in c++14 c++20; do
+    lines=$(echo '#include "either.hpp"' | $CXX -std=$std -I"$here" -x c++ -E - | wc -l)
+    printf '%-44s %8s lines\n' "either.hpp preprocessed, $std" "$lines"
+    budget=$HEADER_BUDGET
+    if [ "$std" = c++20 ]; then
+        budget=$HEADER_BUDGET_CPP20
+    fi
+    if [ "$lines" -gt "$budget" ]; then
+        echo "either.hpp is over its $std budget of $budget preprocessed lines" >&2
+        exit 1
+    fi
+done
+
+cat > "$work/empty.cpp" <<'EOF'
+#include "either.hpp"
+EOF
+
+cat > "$work/many.cpp" <<'EOF'
+#include <utility>
+
+#include "either.hpp"
+
+namespace {
+
+template <int I>
+struct alt {
+    int v;
+    bool operator==(const alt& other) const {
+        return v == other.v;
+    }
+};
+
+template <int I>
+int use() {
+    using either_t = ben::either<alt<I>, alt<-I - 1>>;
+    either_t e(alt<I>{I});
+    either_t f = e;
+    f = alt<-I - 1>{1};
+    f.swap(e);
+    return e.map_left([](alt<I> a) { return a.v; }).is_left() + (e == f);
+}
+
+template <int... Is>
+int use_all(std::integer_sequence<int, Is...>) {
+    const int results[] = {use<Is>()...};
+    int sum = 0;
+    for (int r : results) {
+        sum += r;
+    }
+    return sum;
+}
+
+} // namespace
+
+int run_many() {
+    return use_all(std::make_integer_sequence<int, COUNT>{});
+}
+EOF
+
+cat > "$work/common.cpp" <<'EOF'
+#include <string>
+
+#include "either.hpp"
+#if defined(USE_EXTERN)
+#include "either_common.hpp"
+#endif
+
+template <typename L, typename R>
+int use(const L& l, const R& r) {
+    ben::either<L, R> a(l);
+    ben::either<L, R> b(r);
+    b.emplace_left(l);
+    a.swap(b);
+    a = b;
+    return (a == b) + a.is_left();
+}
+
+int run_common() {
+    return use(1, std::string("x")) + use(std::string("x"), 1) +
+           use(std::int64_t{1}, std::string("x")) + use(1.0, std::string("x"));
+}
+EOF
+
+cat > "$work/instantiate.cpp" <<'EOF'
+#define BEN_EITHER_INSTANTIATE_COMMON
+#include "either_common.hpp"
+EOF
+
+compile() {
+    $CXX "$@" -I"$here" -c -o "$work/out.o"
+}
+
+ms=$(best_ms compile "$@" "$work/empty.cpp")
+report "either.hpp alone" "$ms" "$(wc -c < "$work/out.o")"
+ms=$(best_ms compile "$@" -DCOUNT="$COUNT" "$work/many.cpp")
+report "$COUNT distinct eithers" "$ms" "$(wc -c < "$work/out.o")"
+ms=$(best_ms compile "$@" "$work/common.cpp")
+report "common pairs, implicit instantiation" "$ms" "$(wc -c < "$work/out.o")"
+ms=$(best_ms compile "$@" -DUSE_EXTERN "$work/common.cpp")
+report "common pairs, extern templates" "$ms" "$(wc -c < "$work/out.o")"
+
+# The extern declarations are only useful if the instantiations link.
+cp "$work/out.o" "$work/common.o"
+$CXX "$@" -I"$here" -c "$work/instantiate.cpp" -o "$work/instantiate.o"
+printf 'int run_common();\nint main() { return run_common() > 0 ? 0 : 1; }\n' > "$work/main.cpp"
+$CXX "$@" "$work/main.cpp" "$work/common.o" "$work/instantiate.o" -o "$work/common"
+"$work/common"
@@ -0,0 +1,16 @@
+#!/bin/sh
+# Usage: check_inlined.sh <source.cpp> [compiler flags...]
+# Compiles the source to assembly and fails if any extern "C" function whose
+# name starts with codegen_ contains a call instruction.
+set -e
+src="$1"
+shift
+asm="${src%.cpp}.s"
+${CXX:-c++} "$@" -S "$src" -o "$asm"
+awk '
+    /^codegen_[A-Za-z0-9_]*:/ { fn = $1; sub(":", "", fn); next }
+    /\.cfi_endproc/ { fn = "" }
+    fn != "" && /^[ \t]+call/ { print "not inlined in " fn ": " $0; bad = 1 }
+    END { exit bad }
+' "$asm"
+echo "$src: no calls in codegen_ functions"
@@ -0,0 +1,22 @@
+// Functions whose bodies must compile down to straight-line code at -O2: a
+// call instruction left in any of them means a combinator was not inlined.
+// check_inlined.sh compiles this file to assembly and enforces that.
+
+#include "either.hpp"
+
+using result = ben::either<int, unsigned>;
+
+extern "C" int codegen_map_left(int x) {
+    return result(x).map_left([](int v) { return v * 3; }).map_left([](int v) { return v + 1; }).value_or(0);
+}
+
+extern "C" int codegen_and_then(unsigned e) {
+    return result(e)
+        .and_then([](int v) -> result { return v + 1; })
+        .or_else([](unsigned u) -> result { return static_cast<int>(u) * 2; })
+        .value_or(-1);
+}
+
+extern "C" unsigned codegen_map_right(const result* r) {
+    return r->map_right([](unsigned u) { return u ^ 0x55u; }).is_right() ? 1u : 0u;
+}
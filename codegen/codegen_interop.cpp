@@ -0,0 +1,25 @@
+// Conversions between ben::either and the standard sum types must compile to
+// moves of the tag and value only: a call instruction left in any of these
+// means a conversion went through something out of line.
+
+#include "either_std.hpp"
+
+using result = ben::either<int, unsigned>;
+
+extern "C" int codegen_variant_round_trip(const result* r) {
+    return ben::from_variant(ben::to_variant(*r)).value_or(-1);
+}
+
+extern "C" int codegen_from_variant(std::variant<int, unsigned>* v) {
+    return ben::from_variant(std::move(*v)).value_or(-1);
+}
+
+extern "C" int codegen_optional_round_trip(const result* r) {
+    return ben::from_optional<unsigned>(ben::to_optional(*r), 0u).value_or(-1);
+}
+
+#if defined(__cpp_lib_expected)
+extern "C" int codegen_expected_round_trip(const result* r) {
+    return ben::from_expected(ben::to_expected(*r)).value_or(-1);
+}
+#endif
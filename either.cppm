@@ -0,0 +1,21 @@
+// The C++20 module interface for either.hpp: `import ben.either;` gives
+// ben::either, its specializations for references, ben::visit, ben::swap and
+// the traits in either.hpp. The other headers are not part of the module.
+// Built with `make module`; with GCC that needs -fmodules-ts.
+
+module;
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+export module ben.either;
+
+#if defined(BEN_EITHER_PROFILE)
+#error "the ben.either module does not support BEN_EITHER_PROFILE"
+#endif
+
+#define BEN_EITHER_MODULE
+#include "either.hpp"
@@ -1,61 +1,872 @@
 #pragma once
 
-#include <array>
-#include <cstring>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
 
-namespace ben {
+#if __cplusplus >= 202002L
+// std::construct_at, for construct_in_place, without the rest of <memory>.
+#if __has_include(<bits/stl_construct.h>)
+#include <bits/stl_construct.h>
+#elif __has_include(<__memory/construct_at.h>)
+#include <__memory/construct_at.h>
+#else
+#include <memory>
+#endif
+#define BEN_CONSTEXPR20 constexpr
+#else
+#define BEN_CONSTEXPR20
+#endif
+
+// With BEN_EITHER_PROFILE defined, is_left(), is_right() and visit() take
+// their caller's location as hidden default arguments and count hits per
+// call site; see either_profile.hpp. BEN_PROFILE_SITE declares those
+// parameters, BEN_PROFILE_SITE_DEF repeats them in a definition and
+// BEN_PROFILE_SITE_ARGS passes them on. All three are empty otherwise.
+#if defined(BEN_EITHER_PROFILE)
+#include "either_profile.hpp"
+#define BEN_PROFILE_SITE const char* file = __builtin_FILE(), unsigned line = __builtin_LINE()
+#define BEN_PROFILE_SITE_DEF const char* file, unsigned line
+#define BEN_PROFILE_SITE_ARGS file, line
+#define BEN_PROFILE_RECORD(left) \
+    (__builtin_is_constant_evaluated() ? static_cast<void>(0) : ::ben::detail::profile_record(file, line, left))
+#else
+#define BEN_PROFILE_SITE
+#define BEN_PROFILE_SITE_DEF
+#define BEN_PROFILE_SITE_ARGS
+#define BEN_PROFILE_RECORD(left) static_cast<void>(0)
+#endif
+
+// Inside the ben.either module interface (either.cppm) everything in
+// namespace ben is exported; elsewhere BEN_MODULE_EXPORT is empty.
+#if defined(BEN_EITHER_MODULE)
+#define BEN_MODULE_EXPORT export
+#else
+#define BEN_MODULE_EXPORT
+#endif
+
+BEN_MODULE_EXPORT namespace ben {
+
+template <typename left_type, typename right_type>
+class either;
+
+// zero_either_padding<L, R> opts either<L, R> into a layout with no padding
+// bytes: every byte of the object is either part of the held value or zero,
+// so two eithers holding equal values are equal byte for byte and can be
+// compared with memcmp (see ben::equal in either_algorithm.hpp). Specialize
+// it to true_type for trivially copyable alternatives aligned to at most 8
+// bytes. The tag widens to the alternatives' alignment, and bytes past a
+// smaller alternative are cleared whenever one is built, so before C++20
+// such an either is not usable in constant expressions.
+template <typename left_type, typename right_type>
+struct zero_either_padding : std::false_type {};
+
+namespace detail {
+
+// Result of calling F with an Arg, decayed so it can be stored in an either.
+template <typename F, typename Arg>
+using map_result_t = typename std::decay<decltype(std::declval<F>()(std::declval<Arg>()))>::type;
+
+struct left_tag {};
+struct right_tag {};
+struct from_either_tag {};
+
+// Whether Source, an either instantiation, keeps its alternatives in the
+// layered storage below, which is what the converting constructors and
+// assignments read them from. The specializations with storage of their
+// own (of references, of a cold right) say they do not, and so cannot be
+// converted from.
+template <typename Source>
+struct is_stored_either : std::true_type {};
+template <typename left_type, typename right_type>
+struct is_stored_either<either<left_type&, right_type&>> : std::false_type {};
+
+// Constraints for converting between either instantiations. from_left and
+// from_right are the source alternatives as they will be passed on: const&
+// when converting from an lvalue either, && from an rvalue. The conversion is
+// implicit only when both alternatives convert implicitly.
+template <typename left_type, typename right_type, typename source, typename from_left, typename from_right>
+using is_either_constructible = std::integral_constant<bool,
+    is_stored_either<source>::value &&
+    std::is_constructible<left_type, from_left>::value &&
+    std::is_constructible<right_type, from_right>::value>;
+
+template <typename left_type, typename right_type, typename from_left, typename from_right>
+using is_either_convertible = std::integral_constant<bool,
+    std::is_convertible<from_left, left_type>::value &&
+    std::is_convertible<from_right, right_type>::value>;
+
+template <typename left_type, typename right_type, typename source, typename from_left, typename from_right>
+using enable_implicit_either_t = typename std::enable_if<
+    is_either_constructible<left_type, right_type, source, from_left, from_right>::value &&
+    is_either_convertible<left_type, right_type, from_left, from_right>::value, int>::type;
+
+template <typename left_type, typename right_type, typename source, typename from_left, typename from_right>
+using enable_explicit_either_t = typename std::enable_if<
+    is_either_constructible<left_type, right_type, source, from_left, from_right>::value &&
+    !is_either_convertible<left_type, right_type, from_left, from_right>::value, int>::type;
+
+template <typename left_type, typename right_type, typename source, typename from_left, typename from_right>
+using enable_either_assign_t = typename std::enable_if<
+    is_either_constructible<left_type, right_type, source, from_left, from_right>::value &&
+    std::is_assignable<left_type&, from_left>::value &&
+    std::is_assignable<right_type&, from_right>::value, int>::type;
+
+// construct_in_place begins the lifetime of a T at p with placement new.
+// From C++20 it is also usable in constant expressions, where only
+// std::construct_at may do that.
+template <typename T, typename... Args>
+BEN_CONSTEXPR20 void construct_in_place(T* p, Args&&... args) {
+#if __cplusplus >= 202002L
+    if (std::is_constant_evaluated()) {
+        std::construct_at(p, std::forward<Args>(args)...);
+        return;
+    }
+#endif
+    ::new (static_cast<void*>(p)) T(std::forward<Args>(args)...);
+}
+
+template <typename T>
+BEN_CONSTEXPR20 void destruct(T& in) {
+    in.~T();
+}
+
+// is_nothrow_swappable is std::is_nothrow_swappable for C++14: whether an
+// unqualified swap of two T lvalues, with std::swap visible, cannot throw.
+namespace swap_adl {
+
+using std::swap;
+
+template <typename T>
+struct is_nothrow_swappable
+    : std::integral_constant<bool, noexcept(swap(std::declval<T&>(), std::declval<T&>()))> {};
+
+} // namespace swap_adl
+
+using swap_adl::is_nothrow_swappable;
+
+template <typename left_type, typename right_type>
+using is_nothrow_either_swappable = std::integral_constant<bool,
+    std::is_nothrow_move_constructible<left_type>::value &&
+    std::is_nothrow_move_constructible<right_type>::value &&
+    is_nothrow_swappable<left_type>::value &&
+    is_nothrow_swappable<right_type>::value>;
+
+// The storage of an either is built up in layers, one per special member,
+// so that each special member is trivial (and so usable in constant
+// expressions, and with a trivial destructor the whole either is a literal
+// type) exactly when it is trivial for both alternatives. Each layer that is
+// not trivial supplies its member by hand; the rest are defaulted. With
+// C++20 the hand-written members are constexpr too.
+//
+// The from_either_tag constructor and assign_from take any storage layer,
+// including that of another either instantiation, which is how the
+// converting constructors and assignments move each alternative across.
+
+template <typename left_type, typename right_type,
+          bool = std::is_trivially_destructible<left_type>::value &&
+                 std::is_trivially_destructible<right_type>::value>
+struct either_storage {
+    template <typename... Args>
+    constexpr explicit either_storage(left_tag, Args&&... args)
+        : left_(true), lt_(std::forward<Args>(args)...) {}
+    template <typename... Args>
+    constexpr explicit either_storage(right_tag, Args&&... args)
+        : left_(false), rt_(std::forward<Args>(args)...) {}
+    // Copies or moves the alternative held by other. Done in the body of
+    // this constructor so that if it throws, no destructor runs on storage
+    // that never held a value.
+    template <typename Other>
+    BEN_CONSTEXPR20 either_storage(from_either_tag, Other&& other) : left_(other.left_) {
+        if (left_) {
+            construct_in_place(&lt_, std::forward<Other>(other).lt_);
+        } else {
+            construct_in_place(&rt_, std::forward<Other>(other).rt_);
+        }
+    }
+
+    BEN_CONSTEXPR20 void destruct_self() {}
+    BEN_CONSTEXPR20 void reset_bytes() {}
+
+    bool left_ = false;
+
+    union {
+        left_type lt_;
+        right_type rt_;
+    };
+};
+
+template <typename left_type, typename right_type>
+struct either_storage<left_type, right_type, false> {
+    template <typename... Args>
+    constexpr explicit either_storage(left_tag, Args&&... args)
+        : left_(true), lt_(std::forward<Args>(args)...) {}
+    template <typename... Args>
+    constexpr explicit either_storage(right_tag, Args&&... args)
+        : left_(false), rt_(std::forward<Args>(args)...) {}
+    template <typename Other>
+    BEN_CONSTEXPR20 either_storage(from_either_tag, Other&& other) : left_(other.left_) {
+        if (left_) {
+            construct_in_place(&lt_, std::forward<Other>(other).lt_);
+        } else {
+            construct_in_place(&rt_, std::forward<Other>(other).rt_);
+        }
+    }
+
+    either_storage(const either_storage&) = default;
+    either_storage(either_storage&&) = default;
+    either_storage& operator=(const either_storage&) = default;
+    either_storage& operator=(either_storage&&) = default;
+
+    BEN_CONSTEXPR20 ~either_storage() {
+        destruct_self();
+    }
+
+    BEN_CONSTEXPR20 void destruct_self() {
+        if (left_) {
+            destruct(lt_);
+        } else {
+            destruct(rt_);
+        }
+    }
+    BEN_CONSTEXPR20 void reset_bytes() {}
+
+    bool left_ = false;
+
+    union {
+        left_type lt_;
+        right_type rt_;
+    };
+};
+
+// The storage used under zero_either_padding. The tag is an unsigned word as
+// wide as the union's alignment, so nothing lies between them and the whole
+// is padding-free, and the union has a byte array spanning it that is zeroed
+// before an alternative is built (reset_bytes), which clears whatever lies
+// past a smaller one. Copies stay trivial: a union is copied byte for byte.
+template <std::size_t size>
+struct tag_word;
+template <>
+struct tag_word<1> {
+    using type = std::uint8_t;
+};
+template <>
+struct tag_word<2> {
+    using type = std::uint16_t;
+};
+template <>
+struct tag_word<4> {
+    using type = std::uint32_t;
+};
+template <>
+struct tag_word<8> {
+    using type = std::uint64_t;
+};
+
+template <typename left_type, typename right_type>
+struct either_zeroed_storage {
+    static_assert(std::is_trivially_copyable<left_type>::value && std::is_trivially_copyable<right_type>::value,
+                  "zero_either_padding needs trivially copyable alternatives");
+    static constexpr std::size_t align = alignof(left_type) > alignof(right_type) ? alignof(left_type)
+                                                                                   : alignof(right_type);
+    static_assert(align <= 8, "zero_either_padding needs alternatives aligned to at most 8 bytes");
+    static constexpr std::size_t largest = sizeof(left_type) > sizeof(right_type) ? sizeof(left_type)
+                                                                                  : sizeof(right_type);
+    static constexpr std::size_t size = (largest + align - 1) / align * align;
+
+    template <typename... Args>
+    BEN_CONSTEXPR20 explicit either_zeroed_storage(left_tag, Args&&... args) : left_(1), raw_() {
+        construct_in_place(&lt_, std::forward<Args>(args)...);
+    }
+    template <typename... Args>
+    BEN_CONSTEXPR20 explicit either_zeroed_storage(right_tag, Args&&... args) : left_(0), raw_() {
+        construct_in_place(&rt_, std::forward<Args>(args)...);
+    }
+    template <typename Other>
+    BEN_CONSTEXPR20 either_zeroed_storage(from_either_tag, Other&& other) : left_(other.left_), raw_() {
+        if (left_) {
+            construct_in_place(&lt_, std::forward<Other>(other).lt_);
+        } else {
+            construct_in_place(&rt_, std::forward<Other>(other).rt_);
+        }
+    }
+
+    BEN_CONSTEXPR20 void destruct_self() {}
+    BEN_CONSTEXPR20 void reset_bytes() {
+        construct_in_place(&raw_);
+    }
+
+    struct bytes {
+        unsigned char b[size];
+    };
+
+    typename tag_word<align>::type left_ = 0;
+
+    union {
+        left_type lt_;
+        right_type rt_;
+        bytes raw_;
+    };
+};
+
+template <typename left_type, typename right_type>
+using either_storage_t = typename std::conditional<zero_either_padding<left_type, right_type>::value,
+                                                   either_zeroed_storage<left_type, right_type>,
+                                                   either_storage<left_type, right_type>>::type;
+
+// How replace_value builds a T from Args in place of a held value of type
+// Held without ever leaving the storage holding nothing:
+//   replace_direct  constructing cannot throw, so Held is destroyed and T
+//                   built in its place;
+//   replace_temp    T is built in a temporary first and moved in, which
+//                   cannot throw;
+//   replace_backup  Held is moved to a backup on the stack, which cannot
+//                   throw, and moved back if building T does;
+//   replace_last    neither move is nothrow; T is built in place and a
+//                   throw ends the program (std::terminate) rather than
+//                   leave a destroyed value behind.
+enum replace_strategy {
+    replace_direct,
+    replace_temp,
+    replace_backup,
+    replace_last,
+};
+
+template <typename T, typename Held, typename... Args>
+using replace_strategy_for = std::integral_constant<replace_strategy,
+    std::is_nothrow_constructible<T, Args&&...>::value ? replace_direct :
+    std::is_nothrow_move_constructible<T>::value ? replace_temp :
+    std::is_nothrow_move_constructible<Held>::value ? replace_backup : replace_last>;
+
+template <typename T, typename... Args>
+BEN_CONSTEXPR20 void construct_or_terminate(T* p, Args&&... args) noexcept {
+    construct_in_place(p, std::forward<Args>(args)...);
+}
+
+template <typename T, typename Held, typename Clear, typename... Args>
+BEN_CONSTEXPR20 void replace_value_with(std::integral_constant<replace_strategy, replace_direct>, T* p, Held* held,
+                                        Clear& clear, Args&&... args) {
+    clear(held);
+    construct_in_place(p, std::forward<Args>(args)...);
+}
+
+template <typename T, typename Held, typename Clear, typename... Args>
+BEN_CONSTEXPR20 void replace_value_with(std::integral_constant<replace_strategy, replace_temp>, T* p, Held* held,
+                                        Clear& clear, Args&&... args) {
+    T tmp(std::forward<Args>(args)...);
+    clear(held);
+    construct_in_place(p, std::move(tmp));
+}
+
+template <typename T, typename Held, typename Clear, typename... Args>
+BEN_CONSTEXPR20 void replace_value_with(std::integral_constant<replace_strategy, replace_backup>, T* p, Held* held,
+                                        Clear& clear, Args&&... args) {
+    Held backup(std::move(*held));
+    clear(held);
+    try {
+        construct_in_place(p, std::forward<Args>(args)...);
+    } catch (...) {
+        construct_in_place(held, std::move(backup));
+        throw;
+    }
+}
+
+template <typename T, typename Held, typename Clear, typename... Args>
+BEN_CONSTEXPR20 void replace_value_with(std::integral_constant<replace_strategy, replace_last>, T* p, Held* held,
+                                        Clear& clear, Args&&... args) {
+    clear(held);
+    construct_or_terminate(p, std::forward<Args>(args)...);
+}
+
+// replace_value destroys *held, which is alive, and builds a T from args at
+// p, which may be held itself. clear(held) does the destroying. If building
+// T throws, *held holds its old value again. Every place that swaps one value
+// for another in place (either, its cold specialization, either_array) goes
+// through here.
+template <typename T, typename Held, typename Clear, typename... Args>
+BEN_CONSTEXPR20 void replace_value(T* p, Held* held, Clear clear, Args&&... args) {
+    replace_value_with(replace_strategy_for<T, Held, Args...>{}, p, held, clear, std::forward<Args>(args)...);
+}
+
+// either_ops adds assignment from another either, shared by the two
+// hand-written assignment layers, and replace, which the assignments and
+// emplace use to change the held value. When both hold the same alternative
+// assignment is the alternative's own, with whatever guarantee it gives;
+// otherwise the new alternative replaces the old with the strong guarantee:
+// if building it throws, the either still holds its old value.
+template <typename left_type, typename right_type>
+struct either_ops : either_storage_t<left_type, right_type> {
+    using storage = either_storage_t<left_type, right_type>;
+    using storage::storage;
+
+    template <typename Other>
+    BEN_CONSTEXPR20 void assign_from(Other&& other) {
+        if (this->left_ == other.left_) {
+            if (this->left_) {
+                this->lt_ = std::forward<Other>(other).lt_;
+            } else {
+                this->rt_ = std::forward<Other>(other).rt_;
+            }
+            return;
+        }
+        if (other.left_) {
+            replace(&this->lt_, &this->rt_, true, std::forward<Other>(other).lt_);
+        } else {
+            replace(&this->rt_, &this->lt_, false, std::forward<Other>(other).rt_);
+        }
+    }
+
+    // replace destroys *held, the value this either holds, and builds a T
+    // from args at p, leaving the either a left if left is true. p may be
+    // held itself.
+    template <typename T, typename Held, typename... Args>
+    BEN_CONSTEXPR20 void replace(T* p, Held* held, bool left, Args&&... args) {
+        replace_value(p, held, [this](auto* h) {
+            destruct(*h);
+            this->reset_bytes();
+        }, std::forward<Args>(args)...);
+        this->left_ = left;
+    }
+};
+
+template <typename left_type, typename right_type,
+          bool = std::is_trivially_copy_constructible<left_type>::value &&
+                 std::is_trivially_copy_constructible<right_type>::value>
+struct either_copy_ctor : either_ops<left_type, right_type> {
+    using either_ops<left_type, right_type>::either_ops;
+};
+
+template <typename left_type, typename right_type>
+struct either_copy_ctor<left_type, right_type, false> : either_ops<left_type, right_type> {
+    using either_ops<left_type, right_type>::either_ops;
+
+    BEN_CONSTEXPR20 either_copy_ctor(const either_copy_ctor& other)
+        : either_ops<left_type, right_type>(from_either_tag{}, other) {}
+    either_copy_ctor(either_copy_ctor&&) = default;
+    either_copy_ctor& operator=(const either_copy_ctor&) = default;
+    either_copy_ctor& operator=(either_copy_ctor&&) = default;
+};
+
+template <typename left_type, typename right_type,
+          bool = std::is_trivially_move_constructible<left_type>::value &&
+                 std::is_trivially_move_constructible<right_type>::value>
+struct either_move_ctor : either_copy_ctor<left_type, right_type> {
+    using either_copy_ctor<left_type, right_type>::either_copy_ctor;
+};
+
+template <typename left_type, typename right_type>
+struct either_move_ctor<left_type, right_type, false> : either_copy_ctor<left_type, right_type> {
+    using either_copy_ctor<left_type, right_type>::either_copy_ctor;
+
+    either_move_ctor(const either_move_ctor&) = default;
+    BEN_CONSTEXPR20 either_move_ctor(either_move_ctor&& other)
+        noexcept(std::is_nothrow_move_constructible<left_type>::value &&
+                 std::is_nothrow_move_constructible<right_type>::value)
+        : either_copy_ctor<left_type, right_type>(from_either_tag{}, std::move(other)) {}
+    either_move_ctor& operator=(const either_move_ctor&) = default;
+    either_move_ctor& operator=(either_move_ctor&&) = default;
+};
+
+template <typename T>
+using is_trivially_copy_assignable_all = std::integral_constant<bool,
+    std::is_trivially_copy_assignable<T>::value &&
+    std::is_trivially_copy_constructible<T>::value &&
+    std::is_trivially_destructible<T>::value>;
+
+template <typename T>
+using is_trivially_move_assignable_all = std::integral_constant<bool,
+    std::is_trivially_move_assignable<T>::value &&
+    std::is_trivially_move_constructible<T>::value &&
+    std::is_trivially_destructible<T>::value>;
+
+template <typename left_type, typename right_type,
+          bool = is_trivially_copy_assignable_all<left_type>::value &&
+                 is_trivially_copy_assignable_all<right_type>::value>
+struct either_copy_assign : either_move_ctor<left_type, right_type> {
+    using either_move_ctor<left_type, right_type>::either_move_ctor;
+};
+
+template <typename left_type, typename right_type>
+struct either_copy_assign<left_type, right_type, false> : either_move_ctor<left_type, right_type> {
+    using either_move_ctor<left_type, right_type>::either_move_ctor;
+
+    either_copy_assign(const either_copy_assign&) = default;
+    either_copy_assign(either_copy_assign&&) = default;
+    BEN_CONSTEXPR20 either_copy_assign& operator=(const either_copy_assign& other) {
+        if (this != &other) {
+            this->assign_from(other);
+        }
+        return *this;
+    }
+    either_copy_assign& operator=(either_copy_assign&&) = default;
+};
+
+template <typename left_type, typename right_type,
+          bool = is_trivially_move_assignable_all<left_type>::value &&
+                 is_trivially_move_assignable_all<right_type>::value>
+struct either_move_assign : either_copy_assign<left_type, right_type> {
+    using either_copy_assign<left_type, right_type>::either_copy_assign;
+};
+
+template <typename left_type, typename right_type>
+struct either_move_assign<left_type, right_type, false> : either_copy_assign<left_type, right_type> {
+    using either_copy_assign<left_type, right_type>::either_copy_assign;
+
+    either_move_assign(const either_move_assign&) = default;
+    either_move_assign(either_move_assign&&) = default;
+    either_move_assign& operator=(const either_move_assign&) = default;
+    BEN_CONSTEXPR20 either_move_assign& operator=(either_move_assign&& other) {
+        if (this != &other) {
+            this->assign_from(std::move(other));
+        }
+        return *this;
+    }
+};
+
+template <typename left_type, typename right_type>
+using either_base = either_move_assign<left_type, right_type>;
+
+// address_of is std::addressof without pulling in <memory>.
+template <typename T>
+T* address_of(T& in) {
+    return reinterpret_cast<T*>(&const_cast<char&>(reinterpret_cast<const volatile char&>(in)));
+}
+
+// Storage for an either of two references: a single pointer with the tag in
+// its low bit when both referents are at least 2-byte aligned, otherwise a
+// pointer and a separate tag. Which one is picked when the either is named,
+// so both referents must be complete by then.
+template <typename T, typename U, bool = alignof(T) >= 2 && alignof(U) >= 2>
+class ref_storage {
+public:
+    ref_storage(T& in, left_tag) : bits_(reinterpret_cast<std::uintptr_t>(address_of(in))) {}
+    ref_storage(U& in, right_tag) : bits_(reinterpret_cast<std::uintptr_t>(address_of(in)) | 1) {}
+
+    bool is_left() const {
+        return (bits_ & 1) == 0;
+    }
+    T* left_ptr() const {
+        return reinterpret_cast<T*>(bits_);
+    }
+    U* right_ptr() const {
+        return reinterpret_cast<U*>(bits_ & ~std::uintptr_t{1});
+    }
+
+private:
+    std::uintptr_t bits_;
+};
+
+template <typename T, typename U>
+class ref_storage<T, U, false> {
+public:
+    ref_storage(T& in, left_tag) : left_(true), lp_(address_of(in)) {}
+    ref_storage(U& in, right_tag) : left_(false), rp_(address_of(in)) {}
+
+    bool is_left() const {
+        return left_;
+    }
+    T* left_ptr() const {
+        return lp_;
+    }
+    U* right_ptr() const {
+        return rp_;
+    }
+
+private:
+    bool left_;
+    union {
+        T* lp_;
+        U* rp_;
+    };
+};
+
+} // namespace detail
 
 // either implements a type variant that is either left_type
 // or right type. The caller is responsible for making sure
 // that if they call methods that return a type (e.g. as_left()),
 // that either is actually of that type.
 template <typename left_type, typename right_type>
-class either {
+class either : private detail::either_base<left_type, right_type> {
 public:
-    ~either();
+    // Copy, move and destruction are inherited from detail::either_base, and
+    // are trivial whenever they are trivial for both alternatives. Every
+    // operation is constexpr, so an either of literal types can be built and
+    // used in constant expressions; from C++20 that extends to alternatives
+    // with non-trivial special members.
+    //
+    // An either always holds a value. Assignment between eithers holding the
+    // same alternative uses that alternative's assignment. Assignment that
+    // changes alternative, and emplace_left/emplace_right, give the strong
+    // guarantee: if building the new value throws, the either keeps its old
+    // one. When the construction cannot throw it happens in place, so the
+    // common case costs nothing extra; otherwise the new value is built in a
+    // temporary and moved in, or the old one is moved aside on the stack and
+    // restored on failure. There is no heap backup. Only when neither
+    // alternative is nothrow move constructible does a throw at that point
+    // call std::terminate.
 
-    either(const left_type& input);
-    either(const right_type& input);
+    constexpr either(const left_type& input);
+    constexpr either(const right_type& input);
 
-    either(left_type&& input);
-    either(right_type&& input);
+    constexpr either(left_type&& input);
+    constexpr either(right_type&& input);
 
-    either& operator=(const left_type& other);
-    either& operator=(const right_type& other);
+    constexpr either& operator=(const left_type& other);
+    constexpr either& operator=(const right_type& other);
 
-    either& operator=(left_type&& other);
-    either& operator=(right_type&& other);
+    constexpr either& operator=(left_type&& other);
+    constexpr either& operator=(right_type&& other);
 
-    either(const either& other);
-    either& operator=(const either& other);
+    // Converting constructors from an either of other types, which build the
+    // held alternative straight from other's (moving it, for an rvalue). They
+    // take part when both alternatives are constructible from other's and
+    // other is not an either of references or of a cold right, and are
+    // explicit unless both are implicitly convertible, so
+    // either<int, std::string> widens to either<long, std::string> without
+    // copying the string.
+    template <typename other_left, typename other_right,
+              detail::enable_implicit_either_t<left_type, right_type, either<other_left, other_right>,
+                                               const other_left&, const other_right&> = 0>
+    constexpr either(const either<other_left, other_right>& other);
+    template <typename other_left, typename other_right,
+              detail::enable_explicit_either_t<left_type, right_type, either<other_left, other_right>,
+                                               const other_left&, const other_right&> = 0>
+    constexpr explicit either(const either<other_left, other_right>& other);
+    template <typename other_left, typename other_right,
+              detail::enable_implicit_either_t<left_type, right_type, either<other_left, other_right>,
+                                               other_left&&, other_right&&> = 0>
+    constexpr either(either<other_left, other_right>&& other);
+    template <typename other_left, typename other_right,
+              detail::enable_explicit_either_t<left_type, right_type, either<other_left, other_right>,
+                                               other_left&&, other_right&&> = 0>
+    constexpr explicit either(either<other_left, other_right>&& other);
 
-    either(either&& other);
-    either& operator=(either&& other);
+    // Converting assignments. Like the copy and move assignments, they assign
+    // directly when both hold the same alternative, and otherwise replace
+    // the held value with the new one.
+    template <typename other_left, typename other_right,
+              detail::enable_either_assign_t<left_type, right_type, either<other_left, other_right>,
+                                             const other_left&, const other_right&> = 0>
+    constexpr either& operator=(const either<other_left, other_right>& other);
+    template <typename other_left, typename other_right,
+              detail::enable_either_assign_t<left_type, right_type, either<other_left, other_right>,
+                                             other_left&&, other_right&&> = 0>
+    constexpr either& operator=(either<other_left, other_right>&& other);
 
-    const left_type& as_left() const;
-    const right_type& as_right() const;
+    constexpr const left_type& as_left() const;
+    constexpr const right_type& as_right() const;
 
-    left_type& left_ref();
-    right_type& right_ref();
+    constexpr left_type& left_ref();
+    constexpr right_type& right_ref();
 
-    bool is_left() const;
-    bool is_right() const;
+    // emplace_left destroys the held value and constructs a left from args in
+    // its place, returning it; emplace_right is the mirror image. Unlike
+    // assignment, neither needs the alternatives to be assignable. Like an
+    // assignment that changes alternative, a throw leaves the either holding
+    // its old value (see detail::replace_strategy for how).
+    template <typename... Args>
+    BEN_CONSTEXPR20 left_type& emplace_left(Args&&... args);
+    template <typename... Args>
+    BEN_CONSTEXPR20 right_type& emplace_right(Args&&... args);
 
-    bool operator==(const either& other) const;
+    constexpr bool is_left(BEN_PROFILE_SITE) const;
+    constexpr bool is_right(BEN_PROFILE_SITE) const;
+
+    constexpr bool operator==(const either& other) const;
+
+    // swap exchanges the contents of two eithers. When both hold the same
+    // alternative the values are swapped in place; otherwise, for nothrow
+    // movable alternatives, each value is moved once into the other's
+    // storage. Alternatives whose moves can throw fall back to swapping
+    // through a temporary either, as std::swap would. The free function
+    // ben::swap forwards here, so algorithms that swap through ADL (std::sort,
+    // std::rotate, std::reverse) use it.
+    BEN_CONSTEXPR20 void swap(either& other) noexcept(detail::is_nothrow_either_swappable<left_type, right_type>::value);
+
+    // Monadic combinators. Each comes in &, const& and && flavours; the &&
+    // flavour hands the held value to f (or to the result) as an rvalue, so
+    // a chain on a temporary moves each stage forward instead of copying.
+    // When the mapped type is the same as the source type the && flavour
+    // writes the result back into this object's storage and moves it out.
+
+    // map_left returns f(left) if this is a left, otherwise the right
+    // unchanged. map_right is the mirror image.
+    template <typename F>
+    constexpr either<detail::map_result_t<F, left_type&>, right_type> map_left(F&& f) &;
+    template <typename F>
+    constexpr either<detail::map_result_t<F, const left_type&>, right_type> map_left(F&& f) const&;
+    template <typename F>
+    constexpr either<detail::map_result_t<F, left_type&&>, right_type> map_left(F&& f) &&;
+
+    template <typename F>
+    constexpr either<left_type, detail::map_result_t<F, right_type&>> map_right(F&& f) &;
+    template <typename F>
+    constexpr either<left_type, detail::map_result_t<F, const right_type&>> map_right(F&& f) const&;
+    template <typename F>
+    constexpr either<left_type, detail::map_result_t<F, right_type&&>> map_right(F&& f) &&;
+
+    // and_then returns f(left) if this is a left, otherwise the right. f must
+    // itself return an either with the same right_type.
+    template <typename F>
+    constexpr detail::map_result_t<F, left_type&> and_then(F&& f) &;
+    template <typename F>
+    constexpr detail::map_result_t<F, const left_type&> and_then(F&& f) const&;
+    template <typename F>
+    constexpr detail::map_result_t<F, left_type&&> and_then(F&& f) &&;
+
+    // or_else returns f(right) if this is a right, otherwise the left. f must
+    // itself return an either with the same left_type.
+    template <typename F>
+    constexpr detail::map_result_t<F, right_type&> or_else(F&& f) &;
+    template <typename F>
+    constexpr detail::map_result_t<F, const right_type&> or_else(F&& f) const&;
+    template <typename F>
+    constexpr detail::map_result_t<F, right_type&&> or_else(F&& f) &&;
+
+    // value_or returns the left value, or fallback converted to left_type if
+    // this is a right.
+    template <typename U>
+    constexpr left_type value_or(U&& fallback) const&;
+    template <typename U>
+    constexpr left_type value_or(U&& fallback) &&;
 
 private:
-    template <typename T>
-    static void destruct(T& in);
-    void destruct_self();
+    template <typename, typename>
+    friend class either;
 
-    bool left_ = false;
+    using base = detail::either_base<left_type, right_type>;
 
-    union {
-        left_type lt_;
-        right_type rt_;
-    };
+    BEN_CONSTEXPR20 void swap_different(either& other, std::true_type);
+    BEN_CONSTEXPR20 void swap_different(either& other, std::false_type);
+
+    template <typename result, typename F>
+    constexpr result map_left_rvalue(F&& f, std::true_type);
+    template <typename result, typename F>
+    constexpr result map_left_rvalue(F&& f, std::false_type);
+    template <typename result, typename F>
+    constexpr result map_right_rvalue(F&& f, std::true_type);
+    template <typename result, typename F>
+    constexpr result map_right_rvalue(F&& f, std::false_type);
+};
+
+template <typename left_type, typename right_type>
+BEN_CONSTEXPR20 void swap(either<left_type, right_type>& a, either<left_type, right_type>& b)
+    noexcept(noexcept(a.swap(b))) {
+    a.swap(b);
+}
+
+namespace detail {
+
+// The type an rvalue either hands its held value on as, given the
+// alternative and what left_ref()/right_ref() returns: a reference
+// alternative stays the lvalue it refers to, since the either does not own
+// it; anything else is moved from.
+template <typename Alt, typename Ref>
+using held_rvalue_t = typename std::conditional<std::is_lvalue_reference<Alt>::value, Ref,
+                                                typename std::remove_reference<Ref>::type&&>::type;
+
+// The held values of an either, typed from its accessors so that the
+// specializations (of references, of a cold right) work too.
+template <typename left_type, typename right_type>
+constexpr auto held_left(either<left_type, right_type>& e) -> decltype(e.left_ref()) {
+    return e.left_ref();
+}
+template <typename left_type, typename right_type>
+constexpr auto held_left(const either<left_type, right_type>& e) -> decltype(e.as_left()) {
+    return e.as_left();
+}
+template <typename left_type, typename right_type>
+constexpr auto held_left(either<left_type, right_type>&& e)
+    -> held_rvalue_t<left_type, decltype(e.left_ref())> {
+    return static_cast<held_rvalue_t<left_type, decltype(e.left_ref())>>(e.left_ref());
+}
+
+template <typename left_type, typename right_type>
+constexpr auto held_right(either<left_type, right_type>& e) -> decltype(e.right_ref()) {
+    return e.right_ref();
+}
+template <typename left_type, typename right_type>
+constexpr auto held_right(const either<left_type, right_type>& e) -> decltype(e.as_right()) {
+    return e.as_right();
+}
+template <typename left_type, typename right_type>
+constexpr auto held_right(either<left_type, right_type>&& e)
+    -> held_rvalue_t<right_type, decltype(e.right_ref())> {
+    return static_cast<held_rvalue_t<right_type, decltype(e.right_ref())>>(e.right_ref());
+}
+
+} // namespace detail
+
+// visit calls on_left with the held left or on_right with the held right,
+// passing it as an rvalue when e is one, and returns the result. Both
+// handlers must return the same type. The tag is read through e's own
+// is_left(), so the branch hints of either_likely apply.
+template <typename Either, typename OnLeft, typename OnRight>
+constexpr decltype(auto) visit(Either&& e, OnLeft&& on_left, OnRight&& on_right
+#if defined(BEN_EITHER_PROFILE)
+                               , BEN_PROFILE_SITE
+#endif
+) {
+    if (e.is_left(BEN_PROFILE_SITE_ARGS)) {
+        return std::forward<OnLeft>(on_left)(detail::held_left(std::forward<Either>(e)));
+    }
+    return std::forward<OnRight>(on_right)(detail::held_right(std::forward<Either>(e)));
+}
+
+// either of two references holds neither referent, only a pointer to it,
+// and is the size of one pointer when both referents are at least 2-byte
+// aligned. Like std::reference_wrapper, assignment rebinds rather than
+// assigning through, and it cannot be bound to a temporary. as_left() and
+// left_ref() both give the bound reference. The monadic combinators are only
+// available on the primary template.
+//
+// Because its size depends on the referents' alignment, left_type and
+// right_type must be complete wherever either<left_type&, right_type&> is
+// used as a member or otherwise needs its size; a struct cannot hold one
+// that refers to its own type. ptr_either (either_ptr.hpp), whose size does
+// not depend on its pointees, can: struct node { ptr_either<node*, leaf*> next; }.
+template <typename left_type, typename right_type>
+class either<left_type&, right_type&> {
+public:
+    either(left_type& input);
+    either(right_type& input);
+
+    either(left_type&& input) = delete;
+    either(right_type&& input) = delete;
+
+    either& operator=(left_type& other);
+    either& operator=(right_type& other);
+
+    void swap(either& other) noexcept;
+
+    left_type& as_left() const;
+    right_type& as_right() const;
+
+    left_type& left_ref() const;
+    right_type& right_ref() const;
+
+    bool is_left(BEN_PROFILE_SITE) const;
+    bool is_right(BEN_PROFILE_SITE) const;
+
+    // Compares the referents, as the primary template compares values.
+    bool operator==(const either& other) const;
+
+private:
+    detail::ref_storage<left_type, right_type> ref_;
 };
 
 } // namespace ben
 
 #include "either.ipp"
+
+// Explicit instantiation, for code bases that use the same eithers in many
+// translation units. BEN_EITHER_INSTANTIATE(L, R), in one source file,
+// instantiates every member of either<L, R> there; BEN_EITHER_EXTERN_TEMPLATE(L, R),
+// in a header the other files include, stops them instantiating the members
+// that are not inline (before C++20, the ones marked BEN_CONSTEXPR20) and,
+// without optimization, from emitting the inline ones. either_common.hpp does
+// this for a few common pairs.
+#define BEN_EITHER_INSTANTIATE(...) template class ::ben::either<__VA_ARGS__>
+#define BEN_EITHER_EXTERN_TEMPLATE(...) extern template class ::ben::either<__VA_ARGS__>
@@ -2,127 +2,130 @@
 
 #include "either.hpp"
 
-namespace ben {
+BEN_MODULE_EXPORT namespace ben {
 
 template <typename left_type, typename right_type>
-either<left_type, right_type>::either(const left_type& input) : left_(true), lt_(input) {
+constexpr either<left_type, right_type>::either(const left_type& input) : base(detail::left_tag{}, input) {
 
 }
 
 template <typename left_type, typename right_type>
-either<left_type, right_type>::either(const right_type& input) : left_(false), rt_(input) {
+constexpr either<left_type, right_type>::either(const right_type& input) : base(detail::right_tag{}, input) {
 
 }
 
 template <typename left_type, typename right_type>
-either<left_type, right_type>::either(left_type&& input) : left_(true), lt_(std::move(input)) {
+constexpr either<left_type, right_type>::either(left_type&& input) : base(detail::left_tag{}, std::move(input)) {
 
 }
 
 template <typename left_type, typename right_type>
-either<left_type, right_type>::either(right_type&& input) : left_(false), rt_(std::move(input)) {
+constexpr either<left_type, right_type>::either(right_type&& input) : base(detail::right_tag{}, std::move(input)) {
 
 }
 
 template <typename left_type, typename right_type>
-either<left_type, right_type>& either<left_type, right_type>::operator=(const left_type& input) {
+constexpr either<left_type, right_type>& either<left_type, right_type>::operator=(const left_type& input) {
     *this = either(input);
     return *this;
 }
 
 template <typename left_type, typename right_type>
-either<left_type, right_type>& either<left_type, right_type>::operator=(const right_type& input) {
+constexpr either<left_type, right_type>& either<left_type, right_type>::operator=(const right_type& input) {
     *this = either(input);
     return *this;
 }
 
 template <typename left_type, typename right_type>
-either<left_type, right_type>& either<left_type, right_type>::operator=(left_type&& input) {
+constexpr either<left_type, right_type>& either<left_type, right_type>::operator=(left_type&& input) {
     *this = either(std::move(input));
     return *this;
 }
 
 template <typename left_type, typename right_type>
-either<left_type, right_type>& either<left_type, right_type>::operator=(right_type&& input) {
+constexpr either<left_type, right_type>& either<left_type, right_type>::operator=(right_type&& input) {
     *this = either(std::move(input));
     return *this;
 }
 
 template <typename left_type, typename right_type>
-either<left_type, right_type>::either(const either& other) : left_(other.left_) {
-    if (other.is_left()) {
-        new (&lt_) left_type(other.lt_);
-    } else {
-        new (&rt_) right_type(other.rt_);
-    }
+template <typename other_left, typename other_right,
+          detail::enable_implicit_either_t<left_type, right_type, either<other_left, other_right>,
+                                           const other_left&, const other_right&>>
+constexpr either<left_type, right_type>::either(const either<other_left, other_right>& other)
+    : base(detail::from_either_tag{}, static_cast<const typename either<other_left, other_right>::base&>(other)) {
+
 }
 
 template <typename left_type, typename right_type>
-either<left_type, right_type>& either<left_type, right_type>::operator=(const either& other) {
-    if (this == &other) {
-        return *this;
-    }
-    destruct_self();
-    if (other.is_left()) {
-        lt_ = other.lt_;
-    } else {
-        rt_ = other.rt_;
-    }
-    left_ = other.left_;
-    return *this;
+template <typename other_left, typename other_right,
+          detail::enable_explicit_either_t<left_type, right_type, either<other_left, other_right>,
+                                           const other_left&, const other_right&>>
+constexpr either<left_type, right_type>::either(const either<other_left, other_right>& other)
+    : base(detail::from_either_tag{}, static_cast<const typename either<other_left, other_right>::base&>(other)) {
+
 }
 
 template <typename left_type, typename right_type>
-either<left_type, right_type>::either(either&& other) : left_(other.left_) {
-    if (other.is_left()) {
-        new (&lt_) left_type(std::move(other.lt_));
-    } else {
-        new (&rt_) right_type(std::move(other.rt_));
-    }
+template <typename other_left, typename other_right,
+          detail::enable_implicit_either_t<left_type, right_type, either<other_left, other_right>,
+                                           other_left&&, other_right&&>>
+constexpr either<left_type, right_type>::either(either<other_left, other_right>&& other)
+    : base(detail::from_either_tag{}, static_cast<typename either<other_left, other_right>::base&&>(other)) {
+
 }
 
 template <typename left_type, typename right_type>
-either<left_type, right_type>& either<left_type, right_type>::operator=(either&& other) {
-    if (this == &other) {
-        return *this;
-    }
-    destruct_self();
-    if (other.is_left()) {
-        lt_ = std::move(other.lt_);
-    } else {
-        rt_ = std::move(other.rt_);
-    }
-    left_ = other.left_;
+template <typename other_left, typename other_right,
+          detail::enable_explicit_either_t<left_type, right_type, either<other_left, other_right>,
+                                           other_left&&, other_right&&>>
+constexpr either<left_type, right_type>::either(either<other_left, other_right>&& other)
+    : base(detail::from_either_tag{}, static_cast<typename either<other_left, other_right>::base&&>(other)) {
+
+}
+
+template <typename left_type, typename right_type>
+template <typename other_left, typename other_right,
+          detail::enable_either_assign_t<left_type, right_type, either<other_left, other_right>,
+                                         const other_left&, const other_right&>>
+constexpr either<left_type, right_type>& either<left_type, right_type>::operator=(const either<other_left, other_right>& other) {
+    this->assign_from(static_cast<const typename either<other_left, other_right>::base&>(other));
     return *this;
 }
 
 template <typename left_type, typename right_type>
-const left_type& either<left_type, right_type>::as_left() const {
-    return lt_;
+template <typename other_left, typename other_right,
+          detail::enable_either_assign_t<left_type, right_type, either<other_left, other_right>,
+                                         other_left&&, other_right&&>>
+constexpr either<left_type, right_type>& either<left_type, right_type>::operator=(either<other_left, other_right>&& other) {
+    this->assign_from(static_cast<typename either<other_left, other_right>::base&&>(other));
+    return *this;
 }
 
 template <typename left_type, typename right_type>
-const right_type& either<left_type, right_type>::as_right() const {
-    return rt_;
+constexpr const left_type& either<left_type, right_type>::as_left() const {
+    return this->lt_;
 }
 
 template <typename left_type, typename right_type>
-bool either<left_type, right_type>::is_left() const {
-    return left_;
+constexpr const right_type& either<left_type, right_type>::as_right() const {
+    return this->rt_;
 }
 
 template <typename left_type, typename right_type>
-bool either<left_type, right_type>::is_right() const {
-    return !is_left();
+constexpr bool either<left_type, right_type>::is_left(BEN_PROFILE_SITE_DEF) const {
+    BEN_PROFILE_RECORD(this->left_);
+    return this->left_;
 }
 
 template <typename left_type, typename right_type>
-either<left_type, right_type>::~either<left_type, right_type>() {
-    destruct_self();
+constexpr bool either<left_type, right_type>::is_right(BEN_PROFILE_SITE_DEF) const {
+    BEN_PROFILE_RECORD(this->left_);
+    return !this->left_;
 }
 
 template <typename left_type, typename right_type>
-bool either<left_type, right_type>::operator==(const either& other) const {
+constexpr bool either<left_type, right_type>::operator==(const either& other) const {
 	if (is_left()) {
 		if (!other.is_left()) {
 			return false;
@@ -137,28 +140,302 @@ bool either<left_type, right_type>::operator==(const either& other) const {
 }
 
 template <typename left_type, typename right_type>
-template <typename T>
-void either<left_type, right_type>::destruct(T& in) {
-    in.~T();
+template <typename... Args>
+BEN_CONSTEXPR20 left_type& either<left_type, right_type>::emplace_left(Args&&... args) {
+    if (this->left_) {
+        this->replace(&this->lt_, &this->lt_, true, std::forward<Args>(args)...);
+    } else {
+        this->replace(&this->lt_, &this->rt_, true, std::forward<Args>(args)...);
+    }
+    return this->lt_;
 }
 
 template <typename left_type, typename right_type>
-left_type& either<left_type, right_type>::left_ref() {
-    return lt_;
+template <typename... Args>
+BEN_CONSTEXPR20 right_type& either<left_type, right_type>::emplace_right(Args&&... args) {
+    if (this->left_) {
+        this->replace(&this->rt_, &this->lt_, false, std::forward<Args>(args)...);
+    } else {
+        this->replace(&this->rt_, &this->rt_, false, std::forward<Args>(args)...);
+    }
+    return this->rt_;
 }
 
 template <typename left_type, typename right_type>
-right_type& either<left_type, right_type>::right_ref() {
-    return rt_;
+BEN_CONSTEXPR20 void either<left_type, right_type>::swap(either& other)
+    noexcept(detail::is_nothrow_either_swappable<left_type, right_type>::value) {
+    using std::swap;
+    if (is_left() && other.is_left()) {
+        swap(this->lt_, other.lt_);
+    } else if (is_right() && other.is_right()) {
+        swap(this->rt_, other.rt_);
+    } else {
+        swap_different(other, std::integral_constant<bool,
+            std::is_nothrow_move_constructible<left_type>::value &&
+            std::is_nothrow_move_constructible<right_type>::value>{});
+    }
 }
 
+// The left is moved into a temporary, the right moved across into the
+// storage it vacated, and the temporary moved into the right's old storage:
+// two destructions and three moves, none of which can throw.
 template <typename left_type, typename right_type>
-void either<left_type, right_type>::destruct_self() {
-    if (left_) {
-        destruct(left_ref());
-    } else {
-        destruct(right_ref());
+BEN_CONSTEXPR20 void either<left_type, right_type>::swap_different(either& other, std::true_type) {
+    either& l = is_left() ? *this : other;
+    either& r = is_left() ? other : *this;
+    left_type tmp(std::move(l.lt_));
+    detail::destruct(l.lt_);
+    l.reset_bytes();
+    detail::construct_in_place(&l.rt_, std::move(r.rt_));
+    l.left_ = false;
+    detail::destruct(r.rt_);
+    r.reset_bytes();
+    detail::construct_in_place(&r.lt_, std::move(tmp));
+    r.left_ = true;
+}
+
+template <typename left_type, typename right_type>
+BEN_CONSTEXPR20 void either<left_type, right_type>::swap_different(either& other, std::false_type) {
+    either tmp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(tmp);
+}
+
+template <typename left_type, typename right_type>
+template <typename F>
+constexpr either<detail::map_result_t<F, left_type&>, right_type> either<left_type, right_type>::map_left(F&& f) & {
+    if (is_left()) {
+        return std::forward<F>(f)(this->lt_);
+    }
+    return this->rt_;
+}
+
+template <typename left_type, typename right_type>
+template <typename F>
+constexpr either<detail::map_result_t<F, const left_type&>, right_type> either<left_type, right_type>::map_left(F&& f) const& {
+    if (is_left()) {
+        return std::forward<F>(f)(this->lt_);
+    }
+    return this->rt_;
+}
+
+template <typename left_type, typename right_type>
+template <typename F>
+constexpr either<detail::map_result_t<F, left_type&&>, right_type> either<left_type, right_type>::map_left(F&& f) && {
+    using result = either<detail::map_result_t<F, left_type&&>, right_type>;
+    return map_left_rvalue<result>(std::forward<F>(f), std::is_same<result, either>{});
+}
+
+template <typename left_type, typename right_type>
+template <typename result, typename F>
+constexpr result either<left_type, right_type>::map_left_rvalue(F&& f, std::true_type) {
+    if (is_left()) {
+        emplace_left(std::forward<F>(f)(std::move(this->lt_)));
+    }
+    return std::move(*this);
+}
+
+template <typename left_type, typename right_type>
+template <typename result, typename F>
+constexpr result either<left_type, right_type>::map_left_rvalue(F&& f, std::false_type) {
+    if (is_left()) {
+        return std::forward<F>(f)(std::move(this->lt_));
+    }
+    return std::move(this->rt_);
+}
+
+template <typename left_type, typename right_type>
+template <typename F>
+constexpr either<left_type, detail::map_result_t<F, right_type&>> either<left_type, right_type>::map_right(F&& f) & {
+    if (is_right()) {
+        return std::forward<F>(f)(this->rt_);
+    }
+    return this->lt_;
+}
+
+template <typename left_type, typename right_type>
+template <typename F>
+constexpr either<left_type, detail::map_result_t<F, const right_type&>> either<left_type, right_type>::map_right(F&& f) const& {
+    if (is_right()) {
+        return std::forward<F>(f)(this->rt_);
+    }
+    return this->lt_;
+}
+
+template <typename left_type, typename right_type>
+template <typename F>
+constexpr either<left_type, detail::map_result_t<F, right_type&&>> either<left_type, right_type>::map_right(F&& f) && {
+    using result = either<left_type, detail::map_result_t<F, right_type&&>>;
+    return map_right_rvalue<result>(std::forward<F>(f), std::is_same<result, either>{});
+}
+
+template <typename left_type, typename right_type>
+template <typename result, typename F>
+constexpr result either<left_type, right_type>::map_right_rvalue(F&& f, std::true_type) {
+    if (is_right()) {
+        emplace_right(std::forward<F>(f)(std::move(this->rt_)));
+    }
+    return std::move(*this);
+}
+
+template <typename left_type, typename right_type>
+template <typename result, typename F>
+constexpr result either<left_type, right_type>::map_right_rvalue(F&& f, std::false_type) {
+    if (is_right()) {
+        return std::forward<F>(f)(std::move(this->rt_));
+    }
+    return std::move(this->lt_);
+}
+
+template <typename left_type, typename right_type>
+template <typename F>
+constexpr detail::map_result_t<F, left_type&> either<left_type, right_type>::and_then(F&& f) & {
+    if (is_left()) {
+        return std::forward<F>(f)(this->lt_);
+    }
+    return this->rt_;
+}
+
+template <typename left_type, typename right_type>
+template <typename F>
+constexpr detail::map_result_t<F, const left_type&> either<left_type, right_type>::and_then(F&& f) const& {
+    if (is_left()) {
+        return std::forward<F>(f)(this->lt_);
+    }
+    return this->rt_;
+}
+
+template <typename left_type, typename right_type>
+template <typename F>
+constexpr detail::map_result_t<F, left_type&&> either<left_type, right_type>::and_then(F&& f) && {
+    if (is_left()) {
+        return std::forward<F>(f)(std::move(this->lt_));
+    }
+    return std::move(this->rt_);
+}
+
+template <typename left_type, typename right_type>
+template <typename F>
+constexpr detail::map_result_t<F, right_type&> either<left_type, right_type>::or_else(F&& f) & {
+    if (is_right()) {
+        return std::forward<F>(f)(this->rt_);
+    }
+    return this->lt_;
+}
+
+template <typename left_type, typename right_type>
+template <typename F>
+constexpr detail::map_result_t<F, const right_type&> either<left_type, right_type>::or_else(F&& f) const& {
+    if (is_right()) {
+        return std::forward<F>(f)(this->rt_);
+    }
+    return this->lt_;
+}
+
+template <typename left_type, typename right_type>
+template <typename F>
+constexpr detail::map_result_t<F, right_type&&> either<left_type, right_type>::or_else(F&& f) && {
+    if (is_right()) {
+        return std::forward<F>(f)(std::move(this->rt_));
+    }
+    return std::move(this->lt_);
+}
+
+template <typename left_type, typename right_type>
+template <typename U>
+constexpr left_type either<left_type, right_type>::value_or(U&& fallback) const& {
+    if (is_left()) {
+        return this->lt_;
+    }
+    return static_cast<left_type>(std::forward<U>(fallback));
+}
+
+template <typename left_type, typename right_type>
+template <typename U>
+constexpr left_type either<left_type, right_type>::value_or(U&& fallback) && {
+    if (is_left()) {
+        return std::move(this->lt_);
+    }
+    return static_cast<left_type>(std::forward<U>(fallback));
+}
+
+template <typename left_type, typename right_type>
+constexpr left_type& either<left_type, right_type>::left_ref() {
+    return this->lt_;
+}
+
+template <typename left_type, typename right_type>
+constexpr right_type& either<left_type, right_type>::right_ref() {
+    return this->rt_;
+}
+
+template <typename left_type, typename right_type>
+either<left_type&, right_type&>::either(left_type& input) : ref_(input, detail::left_tag{}) {
+
+}
+
+template <typename left_type, typename right_type>
+either<left_type&, right_type&>::either(right_type& input) : ref_(input, detail::right_tag{}) {
+
+}
+
+template <typename left_type, typename right_type>
+either<left_type&, right_type&>& either<left_type&, right_type&>::operator=(left_type& other) {
+    ref_ = detail::ref_storage<left_type, right_type>(other, detail::left_tag{});
+    return *this;
+}
+
+template <typename left_type, typename right_type>
+either<left_type&, right_type&>& either<left_type&, right_type&>::operator=(right_type& other) {
+    ref_ = detail::ref_storage<left_type, right_type>(other, detail::right_tag{});
+    return *this;
+}
+
+template <typename left_type, typename right_type>
+void either<left_type&, right_type&>::swap(either& other) noexcept {
+    const detail::ref_storage<left_type, right_type> tmp = ref_;
+    ref_ = other.ref_;
+    other.ref_ = tmp;
+}
+
+template <typename left_type, typename right_type>
+left_type& either<left_type&, right_type&>::as_left() const {
+    return *ref_.left_ptr();
+}
+
+template <typename left_type, typename right_type>
+right_type& either<left_type&, right_type&>::as_right() const {
+    return *ref_.right_ptr();
+}
+
+template <typename left_type, typename right_type>
+left_type& either<left_type&, right_type&>::left_ref() const {
+    return *ref_.left_ptr();
+}
+
+template <typename left_type, typename right_type>
+right_type& either<left_type&, right_type&>::right_ref() const {
+    return *ref_.right_ptr();
+}
+
+template <typename left_type, typename right_type>
+bool either<left_type&, right_type&>::is_left(BEN_PROFILE_SITE_DEF) const {
+    BEN_PROFILE_RECORD(ref_.is_left());
+    return ref_.is_left();
+}
+
+template <typename left_type, typename right_type>
+bool either<left_type&, right_type&>::is_right(BEN_PROFILE_SITE_DEF) const {
+    BEN_PROFILE_RECORD(ref_.is_left());
+    return !ref_.is_left();
+}
+
+template <typename left_type, typename right_type>
+bool either<left_type&, right_type&>::operator==(const either& other) const {
+    if (is_left()) {
+        return other.is_left() && as_left() == other.as_left();
     }
+    return other.is_right() && as_right() == other.as_right();
 }
 
 } // namespace ben
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "either.hpp"
+
+namespace ben {
+
+namespace detail {
+
+// Number of eithers classified per pass of batch_visit. Index lists for one
+// block live on the stack, so this bounds the scratch space.
+constexpr std::size_t batch_block = 256;
+
+// tag_mask packs the is_left() bits of up to 64 eithers into a word, bit i
+// set meaning first[i] is a left. Tags are first gathered into a contiguous
+// byte buffer so the mask can be built 16 at a time with movemask.
+template <typename L, typename R>
+std::uint64_t tag_mask(const either<L, R>* first, std::size_t n) {
+    alignas(16) std::uint8_t tags[64] = {};
+    for (std::size_t i = 0; i < n; i++) {
+        tags[i] = first[i].is_left() ? 0xff : 0;
+    }
+    std::uint64_t mask = 0;
+#if defined(__SSE2__)
+    for (std::size_t i = 0; i < 64; i += 16) {
+        const __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(tags + i));
+        mask |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(v))) << i;
+    }
+#else
+    for (std::size_t i = 0; i < 64; i++) {
+        mask |= static_cast<std::uint64_t>(tags[i] & 1) << i;
+    }
+#endif
+    return mask;
+}
+
+// emit_indices writes base + i for every set bit i of mask and returns the
+// number written.
+template <typename Index>
+std::size_t emit_indices(std::uint64_t mask, std::size_t base, Index* out) {
+    std::size_t k = 0;
+    while (mask != 0) {
+        out[k++] = static_cast<Index>(base + static_cast<std::size_t>(__builtin_ctzll(mask)));
+        mask &= mask - 1;
+    }
+    return k;
+}
+
+// has_unique_representation is std::has_unique_object_representations for
+// C++14, through the builtin the standard trait is built on. Compilers
+// without it (GCC before 7, Clang before 6) get false, which turns off the
+// bytewise comparison.
+#if defined(__has_builtin)
+#if __has_builtin(__has_unique_object_representations)
+#define BEN_HAS_UNIQUE_REPRESENTATIONS 1
+#endif
+#endif
+#if !defined(BEN_HAS_UNIQUE_REPRESENTATIONS) && \
+    ((defined(__clang__) && __clang_major__ >= 6) || (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 7))
+#define BEN_HAS_UNIQUE_REPRESENTATIONS 1
+#endif
+
+#if defined(BEN_HAS_UNIQUE_REPRESENTATIONS)
+template <typename T>
+using has_unique_representation = std::integral_constant<bool, __has_unique_object_representations(T)>;
+#else
+template <typename T>
+using has_unique_representation = std::false_type;
+#endif
+
+// Bytes compared with memcmp per step of first_difference, before the block
+// that differs is searched byte by byte.
+constexpr std::size_t compare_block = 4096;
+
+// first_difference returns the offset of the first byte at which a and b
+// differ within [0, n), or n. Equal blocks are skipped with memcmp; the block
+// that differs is scanned 16 bytes at a time.
+inline std::size_t first_difference(const unsigned char* a, const unsigned char* b, std::size_t n) {
+    std::size_t i = 0;
+    while (n - i > compare_block && std::memcmp(a + i, b + i, compare_block) == 0) {
+        i += compare_block;
+    }
+#if defined(__SSE2__)
+    for (; n - i >= 16; i += 16) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        const unsigned same = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)));
+        if (same != 0xffff) {
+            return i + static_cast<std::size_t>(__builtin_ctz(~same));
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (a[i] != b[i]) {
+            return i;
+        }
+    }
+    return n;
+}
+
+} // namespace detail
+
+// is_bitwise_comparable<L, R> holds when two either<L, R> are equal exactly
+// when their bytes are: the either is opted into zero_either_padding and
+// neither alternative has padding bits or several representations of one
+// value. (Opting in also asserts that == on each alternative compares
+// values, which is what unique representations suggest.)
+template <typename L, typename R>
+struct is_bitwise_comparable
+    : std::integral_constant<bool, zero_either_padding<L, R>::value &&
+                                   detail::has_unique_representation<L>::value &&
+                                   detail::has_unique_representation<R>::value> {};
+
+namespace detail {
+
+template <typename L, typename R>
+std::size_t mismatch_impl(const either<L, R>* a, const either<L, R>* b, std::size_t n, std::true_type) {
+    const std::size_t at = first_difference(reinterpret_cast<const unsigned char*>(a),
+                                            reinterpret_cast<const unsigned char*>(b), n * sizeof(either<L, R>));
+    return at / sizeof(either<L, R>);
+}
+
+template <typename L, typename R>
+std::size_t mismatch_impl(const either<L, R>* a, const either<L, R>* b, std::size_t n, std::false_type) {
+    for (std::size_t i = 0; i < n; i++) {
+        if (!(a[i] == b[i])) {
+            return i;
+        }
+    }
+    return n;
+}
+
+template <typename L, typename R>
+bool equal_impl(const either<L, R>* a, const either<L, R>* b, std::size_t n, std::true_type) {
+    return n == 0 || std::memcmp(a, b, n * sizeof(either<L, R>)) == 0;
+}
+
+template <typename L, typename R>
+bool equal_impl(const either<L, R>* a, const either<L, R>* b, std::size_t n, std::false_type) {
+    return mismatch_impl(a, b, n, std::false_type{}) == n;
+}
+
+} // namespace detail
+
+// mismatch returns the index of the first position at which [a, a + n) and
+// [b, b + n) differ, or n if they are equal. Bitwise comparable eithers are
+// compared as bytes, so a long equal prefix costs a few memcmp calls;
+// otherwise elements are compared one by one with ==.
+template <typename L, typename R>
+std::size_t mismatch(const either<L, R>* a, const either<L, R>* b, std::size_t n) {
+    return detail::mismatch_impl(a, b, n, is_bitwise_comparable<L, R>{});
+}
+
+// equal reports whether [a, a + n) and [b, b + n) hold equal eithers, with a
+// single memcmp for bitwise comparable ones.
+template <typename L, typename R>
+bool equal(const either<L, R>* a, const either<L, R>* b, std::size_t n) {
+    return detail::equal_impl(a, b, n, is_bitwise_comparable<L, R>{});
+}
+
+// partition_indices classifies the eithers in [first, first + n), writing the
+// index of every left to left_idx and of every right to right_idx, each in
+// ascending order. Both outputs must have room for n indices. Returns the
+// number of lefts; the remaining n - that many are rights.
+template <typename L, typename R, typename Index>
+std::size_t partition_indices(const either<L, R>* first, std::size_t n, Index* left_idx, Index* right_idx) {
+    std::size_t nl = 0;
+    std::size_t nr = 0;
+    for (std::size_t i = 0; i < n; i += 64) {
+        const std::size_t chunk = n - i < 64 ? n - i : 64;
+        const std::uint64_t valid = chunk == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << chunk) - 1;
+        const std::uint64_t mask = detail::tag_mask(first + i, chunk);
+        nl += detail::emit_indices(mask, i, left_idx + nl);
+        nr += detail::emit_indices(~mask & valid, i, right_idx + nr);
+    }
+    return nl;
+}
+
+namespace detail {
+
+template <typename Either, typename LeftFn, typename RightFn>
+void batch_visit_impl(Either* first, std::size_t n, LeftFn& on_left, RightFn& on_right) {
+    std::uint16_t left_idx[batch_block];
+    std::uint16_t right_idx[batch_block];
+    for (std::size_t start = 0; start < n; start += batch_block) {
+        const std::size_t len = n - start < batch_block ? n - start : batch_block;
+        Either* block = first + start;
+        const std::size_t nl = partition_indices(block, len, left_idx, right_idx);
+        for (std::size_t i = 0; i < nl; i++) {
+            on_left(block[left_idx[i]]);
+        }
+        for (std::size_t i = 0; i < len - nl; i++) {
+            on_right(block[right_idx[i]]);
+        }
+    }
+}
+
+} // namespace detail
+
+// batch_visit calls on_left(left_type&) for every left and on_right(right_type&)
+// for every right in [first, first + n). Rather than branching on each tag it
+// splits every block of eithers into a list of lefts and a list of rights and
+// then runs each handler over its own list, so the dispatch branch is gone
+// from the hot loop. Within a block all lefts are visited before any right;
+// handlers must not depend on the interleaving.
+template <typename L, typename R, typename LeftFn, typename RightFn>
+void batch_visit(either<L, R>* first, std::size_t n, LeftFn&& on_left, RightFn&& on_right) {
+    auto l = [&on_left](either<L, R>& e) { on_left(e.left_ref()); };
+    auto r = [&on_right](either<L, R>& e) { on_right(e.right_ref()); };
+    detail::batch_visit_impl(first, n, l, r);
+}
+
+template <typename L, typename R, typename LeftFn, typename RightFn>
+void batch_visit(const either<L, R>* first, std::size_t n, LeftFn&& on_left, RightFn&& on_right) {
+    auto l = [&on_left](const either<L, R>& e) { on_left(e.as_left()); };
+    auto r = [&on_right](const either<L, R>& e) { on_right(e.as_right()); };
+    detail::batch_visit_impl(first, n, l, r);
+}
+
+} // namespace ben
@@ -0,0 +1,207 @@
+#pragma once
+
+#if __cplusplus < 201703L
+#error "either_arena.hpp requires C++17 (std::pmr)"
+#endif
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "either.hpp"
+#include "either_relocate.hpp"
+
+namespace ben {
+
+// is_arena_disposable<T> is true when a T built with an arena's allocator
+// can be abandoned when the arena is released, without running its
+// destructor: the destructor does nothing but give memory back to the arena,
+// which a monotonic arena ignores anyway. That holds for trivially
+// destructible types and for the pmr string and vector of disposable
+// elements; specialize it for your own arena-aware types.
+template <typename T>
+struct is_arena_disposable : std::is_trivially_destructible<T> {};
+
+template <typename C, typename Traits>
+struct is_arena_disposable<std::pmr::basic_string<C, Traits>> : std::true_type {};
+
+template <typename T>
+struct is_arena_disposable<std::pmr::vector<T>> : is_arena_disposable<T> {};
+
+template <typename left_type, typename right_type>
+struct is_arena_disposable<either<left_type, right_type>>
+    : std::integral_constant<bool, is_arena_disposable<left_type>::value &&
+                                   is_arena_disposable<right_type>::value> {};
+
+namespace detail {
+
+// Builds a T from args, appending the arena's allocator when T is
+// allocator-aware (with the allocator as its last constructor argument, as
+// the pmr containers take it).
+template <typename T, typename... Args>
+T make_with_allocator(std::pmr::memory_resource* arena, Args&&... args) {
+    if constexpr (std::uses_allocator<T, std::pmr::polymorphic_allocator<std::byte>>::value) {
+        return T(std::forward<Args>(args)..., std::pmr::polymorphic_allocator<std::byte>(arena));
+    } else {
+        return T(std::forward<Args>(args)...);
+    }
+}
+
+} // namespace detail
+
+// arena_batch is a growable array of either<left_type, right_type> whose
+// elements, and whatever their allocator-aware alternatives allocate, come
+// from one monotonic arena. Clearing the batch releases the arena in one
+// step. When the either is arena disposable, no per-element destructors run
+// at all; otherwise each element is destroyed first, as a vector would.
+//
+// Elements are read through operator[] and the iterators, which are const,
+// and changed only through assign_left/assign_right, which build the new
+// value with the arena's allocator as emplace_left/emplace_right do. That
+// keeps everything the elements own in the arena, which is what lets clear()
+// skip their destructors.
+//
+// Growing the array moves the elements to a larger block in the arena and
+// leaves the old block unused until the next clear(), so reserve() up front
+// when the size is known. Growth gives the strong guarantee: elements whose
+// moves may throw are copied, and the old ones destroyed only once every
+// copy has been made.
+template <typename left_type, typename right_type>
+class arena_batch {
+public:
+    using value_type = either<left_type, right_type>;
+    static constexpr bool disposable = is_arena_disposable<value_type>::value;
+
+    explicit arena_batch(std::size_t initial_bytes = 64 * 1024,
+                         std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : arena_(initial_bytes, upstream) {}
+    arena_batch(const arena_batch&) = delete;
+    arena_batch& operator=(const arena_batch&) = delete;
+
+    ~arena_batch() {
+        destroy_elements();
+    }
+
+    // The arena, for building alternatives by hand.
+    std::pmr::memory_resource* resource() {
+        return &arena_;
+    }
+
+    // emplace_left and emplace_right append an either holding a left (right)
+    // built from args plus, for allocator-aware types, the arena's
+    // allocator.
+    template <typename... Args>
+    const value_type& emplace_left(Args&&... args) {
+        return push(detail::make_with_allocator<left_type>(&arena_, std::forward<Args>(args)...));
+    }
+    template <typename... Args>
+    const value_type& emplace_right(Args&&... args) {
+        return push(detail::make_with_allocator<right_type>(&arena_, std::forward<Args>(args)...));
+    }
+
+    // assign_left and assign_right replace element i with a left (right)
+    // built from args plus, for allocator-aware types, the arena's
+    // allocator.
+    template <typename... Args>
+    const value_type& assign_left(std::size_t i, Args&&... args) {
+        data_[i].emplace_left(detail::make_with_allocator<left_type>(&arena_, std::forward<Args>(args)...));
+        return data_[i];
+    }
+    template <typename... Args>
+    const value_type& assign_right(std::size_t i, Args&&... args) {
+        data_[i].emplace_right(detail::make_with_allocator<right_type>(&arena_, std::forward<Args>(args)...));
+        return data_[i];
+    }
+
+    void reserve(std::size_t n) {
+        if (n > capacity_) {
+            grow(n);
+        }
+    }
+
+    // clear ends the lifetime of every element and releases the arena, so
+    // references to elements and to memory they own become invalid.
+    void clear() {
+        destroy_elements();
+        data_ = nullptr;
+        size_ = 0;
+        capacity_ = 0;
+        arena_.release();
+    }
+
+    std::size_t size() const {
+        return size_;
+    }
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    const value_type& operator[](std::size_t i) const {
+        return data_[i];
+    }
+
+    const value_type* begin() const {
+        return data_;
+    }
+    const value_type* end() const {
+        return data_ + size_;
+    }
+
+private:
+    template <typename T>
+    value_type& push(T&& alternative) {
+        if (size_ == capacity_) {
+            grow(capacity_ == 0 ? 16 : capacity_ * 2);
+        }
+        value_type* slot = data_ + size_;
+        detail::construct_in_place(slot, std::forward<T>(alternative));
+        size_++;
+        return *slot;
+    }
+
+    void grow(std::size_t n) {
+        value_type* bigger = static_cast<value_type*>(arena_.allocate(n * sizeof(value_type), alignof(value_type)));
+        if constexpr (is_trivially_relocatable<value_type>::value ||
+                      std::is_nothrow_move_constructible<value_type>::value) {
+            uninitialized_relocate(data_, data_ + size_, bigger);
+        } else {
+            // As std::vector does: copy when a move could throw, and leave
+            // the old elements alone until the new ones all exist.
+            std::size_t built = 0;
+            try {
+                for (; built < size_; built++) {
+                    detail::construct_in_place(bigger + built, std::move_if_noexcept(data_[built]));
+                }
+            } catch (...) {
+                for (std::size_t i = 0; i < built; i++) {
+                    bigger[i].~value_type();
+                }
+                throw;
+            }
+            for (std::size_t i = 0; i < size_; i++) {
+                data_[i].~value_type();
+            }
+        }
+        data_ = bigger;
+        capacity_ = n;
+    }
+
+    void destroy_elements() {
+        if (!disposable) {
+            for (std::size_t i = 0; i < size_; i++) {
+                data_[i].~value_type();
+            }
+        }
+    }
+
+    std::pmr::monotonic_buffer_resource arena_;
+    value_type* data_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t capacity_ = 0;
+};
+
+} // namespace ben
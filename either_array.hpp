@@ -0,0 +1,298 @@
+#pragma once
+
+#if __cplusplus < 201703L
+#error "either_array.hpp requires C++17 (aligned operator new)"
+#endif
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "either.hpp"
+
+namespace ben {
+
+// The size of a cache line on the x86-64 and AArch64 parts we target.
+// std::hardware_destructive_interference_size says the same, but GCC warns
+// that its value depends on the tuning flags, which makes it unsafe in a
+// header.
+inline constexpr std::size_t cache_line_size = 64;
+
+// either_split picks how either_array lays out its elements. none stores
+// whole eithers; cold_right keeps each element's tag and left together in
+// the array and its right in a side table, out of the way of the loops that
+// only touch lefts.
+enum class either_split {
+    none,
+    cold_right,
+};
+
+// either_array is a fixed-size array of either<left_type, right_type> whose
+// elements each start on a slot_align boundary. Giving each element its own
+// cache line (slot_align = cache_line_size) stops threads that update
+// neighbouring elements from fighting over the line, at the cost of the
+// padding; the default packs elements as a std::vector would.
+//
+// Every layout has the same indexed interface (is_left(i), left(i),
+// emplace_left(i, ...), get(i) and so on); only either_split::none has
+// operator[], since the split layout stores no either to refer to.
+template <typename left_type, typename right_type,
+          std::size_t slot_align = alignof(either<left_type, right_type>),
+          either_split split = either_split::none>
+class either_array;
+
+namespace detail {
+
+// Storage for the array's slots, allocated with the slots' alignment.
+template <typename T>
+class aligned_buffer {
+public:
+    explicit aligned_buffer(std::size_t n)
+        : data_(n == 0 ? nullptr
+                       : static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))))) {}
+    aligned_buffer(const aligned_buffer&) = delete;
+    aligned_buffer& operator=(const aligned_buffer&) = delete;
+
+    ~aligned_buffer() {
+        if (data_ != nullptr) {
+            ::operator delete(data_, std::align_val_t(alignof(T)));
+        }
+    }
+
+    T* get() const {
+        return data_;
+    }
+
+private:
+    T* data_;
+};
+
+// Replaces the value at p, which is alive, with a T built from args, through
+// detail::replace_value, so a throw leaves the old value in place.
+template <typename T, typename... Args>
+void reemplace(T* p, Args&&... args) {
+    replace_value(p, p, [](T* q) { q->~T(); }, std::forward<Args>(args)...);
+}
+
+} // namespace detail
+
+template <typename left_type, typename right_type, std::size_t slot_align>
+class either_array<left_type, right_type, slot_align, either_split::none> {
+public:
+    using value_type = either<left_type, right_type>;
+
+    static_assert((slot_align & (slot_align - 1)) == 0, "slot_align must be a power of two");
+
+    // Builds n elements, each a copy of init.
+    either_array(std::size_t n, const value_type& init) : slots_(n), size_(0) {
+        try {
+            for (; size_ < n; size_++) {
+                ::new (static_cast<void*>(&slots_.get()[size_])) slot{init};
+            }
+        } catch (...) {
+            destroy_elements();
+            throw;
+        }
+    }
+    either_array(const either_array&) = delete;
+    either_array& operator=(const either_array&) = delete;
+
+    ~either_array() {
+        destroy_elements();
+    }
+
+    std::size_t size() const {
+        return size_;
+    }
+
+    value_type& operator[](std::size_t i) {
+        return slots_.get()[i].value;
+    }
+    const value_type& operator[](std::size_t i) const {
+        return slots_.get()[i].value;
+    }
+
+    bool is_left(std::size_t i) const {
+        return (*this)[i].is_left();
+    }
+    bool is_right(std::size_t i) const {
+        return (*this)[i].is_right();
+    }
+
+    left_type& left(std::size_t i) {
+        return (*this)[i].left_ref();
+    }
+    const left_type& left(std::size_t i) const {
+        return (*this)[i].as_left();
+    }
+    right_type& right(std::size_t i) {
+        return (*this)[i].right_ref();
+    }
+    const right_type& right(std::size_t i) const {
+        return (*this)[i].as_right();
+    }
+
+    template <typename... Args>
+    left_type& emplace_left(std::size_t i, Args&&... args) {
+        return (*this)[i].emplace_left(std::forward<Args>(args)...);
+    }
+    template <typename... Args>
+    right_type& emplace_right(std::size_t i, Args&&... args) {
+        return (*this)[i].emplace_right(std::forward<Args>(args)...);
+    }
+
+    value_type get(std::size_t i) const {
+        return (*this)[i];
+    }
+
+private:
+    // A slot_align below the either's own alignment leaves the elements
+    // packed rather than being an error.
+    struct alignas(slot_align > alignof(value_type) ? slot_align : alignof(value_type)) slot {
+        value_type value;
+    };
+
+    void destroy_elements() {
+        for (std::size_t i = 0; i < size_; i++) {
+            slots_.get()[i].~slot();
+        }
+    }
+
+    detail::aligned_buffer<slot> slots_;
+    std::size_t size_;
+};
+
+// The split layout. Each slot holds the tag and the storage for a left; the
+// storage for element i's right is entry i of a separate, unpadded table, so
+// rights cost no space in the hot slots and only rights that are written
+// touch the table. Writes to rights of neighbouring elements can share a
+// cache line, which is meant to be rare.
+template <typename left_type, typename right_type, std::size_t slot_align>
+class either_array<left_type, right_type, slot_align, either_split::cold_right> {
+public:
+    using value_type = either<left_type, right_type>;
+
+    static_assert((slot_align & (slot_align - 1)) == 0, "slot_align must be a power of two");
+
+    either_array(std::size_t n, const value_type& init) : hot_(n), cold_(n), size_(0) {
+        try {
+            for (; size_ < n; size_++) {
+                hot_slot& h = *::new (static_cast<void*>(&hot_.get()[size_])) hot_slot;
+                if (init.is_left()) {
+                    ::new (static_cast<void*>(h.left_ptr())) left_type(init.as_left());
+                } else {
+                    ::new (static_cast<void*>(cold_.get()[size_].right_ptr())) right_type(init.as_right());
+                }
+                h.is_left = init.is_left();
+            }
+        } catch (...) {
+            destroy_elements();
+            throw;
+        }
+    }
+    either_array(const either_array&) = delete;
+    either_array& operator=(const either_array&) = delete;
+
+    ~either_array() {
+        destroy_elements();
+    }
+
+    std::size_t size() const {
+        return size_;
+    }
+
+    bool is_left(std::size_t i) const {
+        return hot_.get()[i].is_left;
+    }
+    bool is_right(std::size_t i) const {
+        return !is_left(i);
+    }
+
+    left_type& left(std::size_t i) {
+        return *hot_.get()[i].left_ptr();
+    }
+    const left_type& left(std::size_t i) const {
+        return *hot_.get()[i].left_ptr();
+    }
+    right_type& right(std::size_t i) {
+        return *cold_.get()[i].right_ptr();
+    }
+    const right_type& right(std::size_t i) const {
+        return *cold_.get()[i].right_ptr();
+    }
+
+    template <typename... Args>
+    left_type& emplace_left(std::size_t i, Args&&... args) {
+        hot_slot& h = hot_.get()[i];
+        if (h.is_left) {
+            detail::reemplace(h.left_ptr(), std::forward<Args>(args)...);
+        } else {
+            detail::replace_value(h.left_ptr(), cold_.get()[i].right_ptr(), [](right_type* r) { r->~right_type(); },
+                                  std::forward<Args>(args)...);
+            h.is_left = true;
+        }
+        return *h.left_ptr();
+    }
+    template <typename... Args>
+    right_type& emplace_right(std::size_t i, Args&&... args) {
+        hot_slot& h = hot_.get()[i];
+        right_type* r = cold_.get()[i].right_ptr();
+        if (!h.is_left) {
+            detail::reemplace(r, std::forward<Args>(args)...);
+        } else {
+            detail::replace_value(r, h.left_ptr(), [](left_type* l) { l->~left_type(); },
+                                  std::forward<Args>(args)...);
+            h.is_left = false;
+        }
+        return *r;
+    }
+
+    value_type get(std::size_t i) const {
+        return is_left(i) ? value_type(left(i)) : value_type(right(i));
+    }
+
+private:
+    struct alignas(slot_align > alignof(left_type) ? slot_align : alignof(left_type)) hot_slot {
+        bool is_left;
+        alignas(left_type) unsigned char left[sizeof(left_type)];
+
+        left_type* left_ptr() {
+            return std::launder(reinterpret_cast<left_type*>(left));
+        }
+        const left_type* left_ptr() const {
+            return std::launder(reinterpret_cast<const left_type*>(left));
+        }
+    };
+
+    struct cold_slot {
+        alignas(right_type) unsigned char right[sizeof(right_type)];
+
+        right_type* right_ptr() {
+            return std::launder(reinterpret_cast<right_type*>(right));
+        }
+        const right_type* right_ptr() const {
+            return std::launder(reinterpret_cast<const right_type*>(right));
+        }
+    };
+
+    void destroy(std::size_t i) {
+        if (is_left(i)) {
+            left(i).~left_type();
+        } else {
+            right(i).~right_type();
+        }
+    }
+
+    void destroy_elements() {
+        for (std::size_t i = 0; i < size_; i++) {
+            destroy(i);
+        }
+    }
+
+    detail::aligned_buffer<hot_slot> hot_;
+    detail::aligned_buffer<cold_slot> cold_;
+    std::size_t size_;
+};
+
+} // namespace ben
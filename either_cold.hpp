@@ -0,0 +1,474 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "either.hpp"
+#include "either_layout.hpp"
+#include "either_likely.hpp"
+#include "either_relocate.hpp"
+
+#if defined(__GNUC__)
+#define BEN_COLD __attribute__((cold, noinline))
+#else
+#define BEN_COLD
+#endif
+
+// On clang the out-of-line either can be passed and returned in registers
+// despite its destructor. GCC has no equivalent, so there it shrinks the
+// object but is still returned through memory.
+#if defined(__clang__)
+#define BEN_TRIVIAL_ABI [[clang::trivial_abi]]
+#else
+#define BEN_TRIVIAL_ABI
+#endif
+
+namespace ben {
+
+// cold marks the right alternative of an either as rare. either<L, cold<R>>
+// keeps R out of line, behind a pointer to a block from a thread-local pool,
+// so the object is only as large as L plus a pointer and the tag. Everything
+// that touches R is moved out of line and marked cold, keeping the success
+// path small. Accessors take and return R itself; cold<R> is never an object.
+template <typename T>
+struct cold;
+
+namespace detail {
+
+template <typename left_type, typename right_type>
+struct is_stored_either<either<left_type, cold<right_type>>> : std::false_type {};
+
+// cold_pool recycles blocks for out-of-line values of type T. Freed blocks go
+// on a free list for the thread that frees them (up to max_cached of them);
+// blocks are individually allocated, so one may be freed on another thread.
+// Once a thread's cache has been destroyed at thread or program exit, eithers
+// destroyed after it (those with static or thread storage, say) free their
+// blocks straight to the heap.
+template <typename T>
+class cold_pool {
+public:
+    static_assert(alignof(T) <= alignof(std::max_align_t), "cold<T> does not support over-aligned T");
+
+    template <typename... Args>
+    BEN_COLD static T* create(Args&&... args) {
+        void* block = acquire();
+        try {
+            return ::new (block) T(std::forward<Args>(args)...);
+        } catch (...) {
+            release(block);
+            throw;
+        }
+    }
+
+    BEN_COLD static void destroy(T* p) noexcept {
+        if (p == nullptr) {
+            return;
+        }
+        p->~T();
+        release(p);
+    }
+
+private:
+    static constexpr std::size_t max_cached = 64;
+    static constexpr std::size_t block_size = sizeof(T) < sizeof(void*) ? sizeof(void*) : sizeof(T);
+
+    struct free_block {
+        free_block* next;
+    };
+
+    struct cache {
+        free_block* head = nullptr;
+        std::size_t size = 0;
+
+        ~cache() {
+            gone() = true;
+            while (head != nullptr) {
+                free_block* next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+    };
+
+    // Set when this thread's cache is destroyed. Being trivially
+    // destructible, it stays usable until the thread's storage is released.
+    static bool& gone() noexcept {
+        static thread_local bool g = false;
+        return g;
+    }
+
+    // The calling thread's cache, or null once it has been destroyed.
+    static cache* local() noexcept {
+        if (gone()) {
+            return nullptr;
+        }
+        static thread_local cache c;
+        return &c;
+    }
+
+    static void* acquire() {
+        cache* c = local();
+        if (c != nullptr && c->head != nullptr) {
+            free_block* b = c->head;
+            c->head = b->next;
+            c->size--;
+            return b;
+        }
+        return ::operator new(block_size);
+    }
+
+    static void release(void* p) noexcept {
+        cache* c = local();
+        if (c == nullptr || c->size == max_cached) {
+            ::operator delete(p);
+            return;
+        }
+        free_block* b = static_cast<free_block*>(p);
+        b->next = c->head;
+        c->head = b;
+        c->size++;
+    }
+};
+
+// trivial_abi_unless is an empty base for either<L, cold<R>>. BEN_TRIVIAL_ABI
+// has no effect on a class with a base that is not trivial for calls, so
+// this one, non-trivial when the left cannot be relocated by copying its
+// bytes, turns the attribute off for such lefts.
+template <bool trivial>
+struct trivial_abi_unless {};
+
+template <>
+struct trivial_abi_unless<false> {
+    trivial_abi_unless() = default;
+    trivial_abi_unless(const trivial_abi_unless&) {}
+    trivial_abi_unless& operator=(const trivial_abi_unless&) = default;
+    ~trivial_abi_unless() {}
+};
+
+} // namespace detail
+
+// either<left_type, cold<right_type>> has the primary template's
+// construction from either alternative, copy, move, assignment, emplace_left/
+// emplace_right, swap, value_or, the accessors and ==, with right_type as
+// the right alternative; it works with ben::visit. The monadic combinators
+// (map_left, map_right, and_then, or_else) and the converting constructors
+// and assignments are only available on the primary template.
+//
+// Moving a right hands over its block. The moved-from either is then left
+// holding a value-initialized left when that cannot throw; otherwise the
+// right is moved into a new block instead, and the moved-from either keeps
+// its own, moved-from, right.
+//
+// Assignment and emplace give the same guarantees as the primary template's:
+// between lefts assignment is the left's own, and otherwise a throw leaves
+// the either holding its old value. A new right is built out of line before
+// anything is destroyed, so replacing with a right never loses the old value.
+template <typename left_type, typename right_type>
+class BEN_TRIVIAL_ABI either<left_type, cold<right_type>>
+    : detail::trivial_abi_unless<is_trivially_relocatable<left_type>::value> {
+    // Whether moving a right hands over its block (see above); if so,
+    // moves are nothrow whenever the left's are.
+    static constexpr bool steals_right = std::is_nothrow_default_constructible<left_type>::value;
+    static constexpr bool nothrow_move = steals_right &&
+                                         std::is_nothrow_move_constructible<left_type>::value &&
+                                         std::is_nothrow_move_assignable<left_type>::value;
+
+public:
+    ~either();
+
+    either(const left_type& input);
+    either(const right_type& input);
+
+    either(left_type&& input);
+    either(right_type&& input);
+
+    either& operator=(const left_type& other);
+    either& operator=(const right_type& other);
+
+    either& operator=(left_type&& other);
+    either& operator=(right_type&& other);
+
+    either(const either& other);
+    either& operator=(const either& other);
+
+    either(either&& other) noexcept(steals_right && std::is_nothrow_move_constructible<left_type>::value);
+    either& operator=(either&& other) noexcept(nothrow_move);
+
+    // Two rights swap their pointers; otherwise the values are exchanged
+    // through a temporary.
+    void swap(either& other) noexcept(nothrow_move);
+
+    const left_type& as_left() const;
+    const right_type& as_right() const;
+
+    left_type& left_ref();
+    right_type& right_ref();
+
+    template <typename... Args>
+    left_type& emplace_left(Args&&... args);
+    template <typename... Args>
+    right_type& emplace_right(Args&&... args);
+
+    template <typename U>
+    left_type value_or(U&& fallback) const&;
+    template <typename U>
+    left_type value_or(U&& fallback) &&;
+
+    bool is_left(BEN_PROFILE_SITE) const;
+    bool is_right(BEN_PROFILE_SITE) const;
+
+    bool operator==(const either& other) const;
+
+private:
+    using pool = detail::cold_pool<right_type>;
+    using abi_base = detail::trivial_abi_unless<is_trivially_relocatable<left_type>::value>;
+
+    void destruct_self();
+
+    // take_right returns a block holding the right other holds, as
+    // described above.
+    static right_type* take_right(either& other, std::true_type) noexcept;
+    static right_type* take_right(either& other, std::false_type);
+
+    // replace_right builds a left from args over the right this either
+    // holds, with the strong guarantee. The right lives out of line, so only
+    // its pointer is in the way: that is what detail::replace_value sets
+    // aside and puts back on a throw, and the right itself is destroyed once
+    // the left is built.
+    template <typename... Args>
+    void replace_right(Args&&... args);
+
+    bool left_ = false;
+
+    union {
+        left_type lt_;
+        right_type* rt_;
+    };
+};
+
+template <typename left_type, typename right_type>
+either<left_type, cold<right_type>>::either(const left_type& input) : left_(true), lt_(input) {
+
+}
+
+template <typename left_type, typename right_type>
+either<left_type, cold<right_type>>::either(left_type&& input) : left_(true), lt_(std::move(input)) {
+
+}
+
+template <typename left_type, typename right_type>
+either<left_type, cold<right_type>>::either(const right_type& input) : left_(false), rt_(pool::create(input)) {
+
+}
+
+template <typename left_type, typename right_type>
+either<left_type, cold<right_type>>::either(right_type&& input) : left_(false), rt_(pool::create(std::move(input))) {
+
+}
+
+template <typename left_type, typename right_type>
+either<left_type, cold<right_type>>& either<left_type, cold<right_type>>::operator=(const left_type& input) {
+    *this = either(input);
+    return *this;
+}
+
+template <typename left_type, typename right_type>
+either<left_type, cold<right_type>>& either<left_type, cold<right_type>>::operator=(const right_type& input) {
+    *this = either(input);
+    return *this;
+}
+
+template <typename left_type, typename right_type>
+either<left_type, cold<right_type>>& either<left_type, cold<right_type>>::operator=(left_type&& input) {
+    *this = either(std::move(input));
+    return *this;
+}
+
+template <typename left_type, typename right_type>
+either<left_type, cold<right_type>>& either<left_type, cold<right_type>>::operator=(right_type&& input) {
+    *this = either(std::move(input));
+    return *this;
+}
+
+template <typename left_type, typename right_type>
+either<left_type, cold<right_type>>::either(const either& other) : abi_base(), left_(other.left_) {
+    if (BEN_EXPECT(other.is_left(), 1)) {
+        new (&lt_) left_type(other.lt_);
+    } else {
+        rt_ = pool::create(*other.rt_);
+    }
+}
+
+template <typename left_type, typename right_type>
+either<left_type, cold<right_type>>& either<left_type, cold<right_type>>::operator=(const either& other) {
+    if (this == &other) {
+        return *this;
+    }
+    *this = either(other);
+    return *this;
+}
+
+template <typename left_type, typename right_type>
+either<left_type, cold<right_type>>::either(either&& other)
+    noexcept(steals_right && std::is_nothrow_move_constructible<left_type>::value) : left_(other.left_) {
+    if (BEN_EXPECT(other.is_left(), 1)) {
+        new (&lt_) left_type(std::move(other.lt_));
+    } else {
+        rt_ = take_right(other, std::integral_constant<bool, steals_right>{});
+    }
+}
+
+template <typename left_type, typename right_type>
+either<left_type, cold<right_type>>& either<left_type, cold<right_type>>::operator=(either&& other)
+    noexcept(nothrow_move) {
+    if (this == &other) {
+        return *this;
+    }
+    if (BEN_EXPECT(other.is_left(), 1)) {
+        if (left_) {
+            lt_ = std::move(other.lt_);
+        } else {
+            replace_right(std::move(other.lt_));
+        }
+        return *this;
+    }
+    right_type* p = take_right(other, std::integral_constant<bool, steals_right>{});
+    destruct_self();
+    rt_ = p;
+    left_ = false;
+    return *this;
+}
+
+template <typename left_type, typename right_type>
+void either<left_type, cold<right_type>>::swap(either& other) noexcept(nothrow_move) {
+    if (!left_ && !other.left_) {
+        right_type* p = rt_;
+        rt_ = other.rt_;
+        other.rt_ = p;
+        return;
+    }
+    either tmp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(tmp);
+}
+
+template <typename left_type, typename right_type>
+const left_type& either<left_type, cold<right_type>>::as_left() const {
+    return lt_;
+}
+
+template <typename left_type, typename right_type>
+const right_type& either<left_type, cold<right_type>>::as_right() const {
+    return *rt_;
+}
+
+template <typename left_type, typename right_type>
+left_type& either<left_type, cold<right_type>>::left_ref() {
+    return lt_;
+}
+
+template <typename left_type, typename right_type>
+right_type& either<left_type, cold<right_type>>::right_ref() {
+    return *rt_;
+}
+
+template <typename left_type, typename right_type>
+template <typename... Args>
+left_type& either<left_type, cold<right_type>>::emplace_left(Args&&... args) {
+    if (BEN_EXPECT(left_, 1)) {
+        detail::replace_value(&lt_, &lt_, [](left_type* l) { l->~left_type(); }, std::forward<Args>(args)...);
+    } else {
+        replace_right(std::forward<Args>(args)...);
+    }
+    return lt_;
+}
+
+template <typename left_type, typename right_type>
+template <typename... Args>
+right_type& either<left_type, cold<right_type>>::emplace_right(Args&&... args) {
+    right_type* p = pool::create(std::forward<Args>(args)...);
+    destruct_self();
+    rt_ = p;
+    left_ = false;
+    return *rt_;
+}
+
+template <typename left_type, typename right_type>
+template <typename U>
+left_type either<left_type, cold<right_type>>::value_or(U&& fallback) const& {
+    return BEN_EXPECT(left_, 1) ? lt_ : static_cast<left_type>(std::forward<U>(fallback));
+}
+
+template <typename left_type, typename right_type>
+template <typename U>
+left_type either<left_type, cold<right_type>>::value_or(U&& fallback) && {
+    return BEN_EXPECT(left_, 1) ? std::move(lt_) : static_cast<left_type>(std::forward<U>(fallback));
+}
+
+template <typename left_type, typename right_type>
+bool either<left_type, cold<right_type>>::is_left(BEN_PROFILE_SITE_DEF) const {
+    BEN_PROFILE_RECORD(left_);
+    return left_;
+}
+
+template <typename left_type, typename right_type>
+bool either<left_type, cold<right_type>>::is_right(BEN_PROFILE_SITE_DEF) const {
+    BEN_PROFILE_RECORD(left_);
+    return !left_;
+}
+
+template <typename left_type, typename right_type>
+either<left_type, cold<right_type>>::~either() {
+    destruct_self();
+}
+
+template <typename left_type, typename right_type>
+bool either<left_type, cold<right_type>>::operator==(const either& other) const {
+    if (is_left()) {
+        return other.is_left() && as_left() == other.as_left();
+    }
+    return other.is_right() && as_right() == other.as_right();
+}
+
+template <typename left_type, typename right_type>
+template <typename... Args>
+void either<left_type, cold<right_type>>::replace_right(Args&&... args) {
+    right_type* old = rt_;
+    detail::replace_value(&lt_, &rt_, [](right_type**) {}, std::forward<Args>(args)...);
+    left_ = true;
+    pool::destroy(old);
+}
+
+template <typename left_type, typename right_type>
+right_type* either<left_type, cold<right_type>>::take_right(either& other, std::true_type) noexcept {
+    right_type* p = other.rt_;
+    new (&other.lt_) left_type();
+    other.left_ = true;
+    return p;
+}
+
+template <typename left_type, typename right_type>
+right_type* either<left_type, cold<right_type>>::take_right(either& other, std::false_type) {
+    return pool::create(std::move(*other.rt_));
+}
+
+template <typename left_type, typename right_type>
+void either<left_type, cold<right_type>>::destruct_self() {
+    if (BEN_EXPECT(left_, 1)) {
+        lt_.~left_type();
+    } else {
+        pool::destroy(rt_);
+    }
+}
+
+// A cold right is only a pointer, so relocation depends on the left alone.
+template <typename left_type, typename right_type>
+struct is_trivially_relocatable<either<left_type, cold<right_type>>> : is_trivially_relocatable<left_type> {};
+
+template <typename left_type, typename right_type>
+struct either_layout<left_type, cold<right_type>>
+    : detail::tagged_union_layout<either<left_type, cold<right_type>>, bool, left_type, right_type*> {};
+
+} // namespace ben
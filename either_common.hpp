@@ -0,0 +1,29 @@
+#pragma once
+
+// Explicit instantiations of either for a few pairs that turn up across
+// most code bases. Every translation unit that includes this header uses the
+// members instantiated in one source file, which defines
+// BEN_EITHER_INSTANTIATE_COMMON before including it:
+//
+//   // either_common.cpp
+//   #define BEN_EITHER_INSTANTIATE_COMMON
+//   #include "either_common.hpp"
+//
+// `make bench-compile` measures what this saves.
+
+#include <cstdint>
+#include <string>
+
+#include "either.hpp"
+
+#define BEN_EITHER_COMMON_PAIRS(X) \
+    X(int, std::string);           \
+    X(std::string, int);           \
+    X(std::int64_t, std::string);  \
+    X(double, std::string)
+
+#if defined(BEN_EITHER_INSTANTIATE_COMMON)
+BEN_EITHER_COMMON_PAIRS(BEN_EITHER_INSTANTIATE);
+#else
+BEN_EITHER_COMMON_PAIRS(BEN_EITHER_EXTERN_TEMPLATE);
+#endif
@@ -0,0 +1,301 @@
+#pragma once
+
+#if !defined(__cpp_impl_coroutine)
+#error "either_coro.hpp requires C++20 coroutine support"
+#endif
+
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "either.hpp"
+
+namespace ben {
+
+namespace detail {
+
+// frame_pool hands out coroutine frames from a fixed thread-local buffer with
+// one free list per 64-byte size class, so a co_either call does not touch
+// the heap. Only a frame larger than max_frame, or one requested once the
+// buffer is used up, falls back to operator new. A frame must be freed on the
+// thread that allocated it: the buffer and free lists belong to that thread,
+// and are neither locked nor kept alive past its exit. The state is
+// trivially destructible, so it stays usable by frames freed during that
+// thread's exit, after other thread_local objects are gone.
+class frame_pool {
+public:
+    static constexpr std::size_t granularity = 64;
+    static constexpr std::size_t max_frame = 1024;
+    static constexpr std::size_t capacity = 64 * 1024;
+
+    static void* allocate(std::size_t n) {
+        state& s = local();
+        if (n <= max_frame) {
+            const std::size_t cls = size_class(n);
+            if (s.free[cls] != nullptr) {
+                free_block* b = s.free[cls];
+                s.free[cls] = b->next;
+                return b;
+            }
+            const std::size_t bytes = (cls + 1) * granularity;
+            if (s.used + bytes <= capacity) {
+                void* p = s.buffer + s.used;
+                s.used += bytes;
+                return p;
+            }
+        }
+        s.heap_allocations++;
+        return ::operator new(n);
+    }
+
+    static void deallocate(void* p, std::size_t n) noexcept {
+        state& s = local();
+        unsigned char* c = static_cast<unsigned char*>(p);
+        if (c >= s.buffer && c < s.buffer + capacity) {
+            free_block* b = static_cast<free_block*>(p);
+            const std::size_t cls = size_class(n);
+            b->next = s.free[cls];
+            s.free[cls] = b;
+            return;
+        }
+        ::operator delete(p);
+    }
+
+    // Number of frames on this thread that did not fit in the pool.
+    static std::size_t heap_allocations() {
+        return local().heap_allocations;
+    }
+
+    // Identifies the calling thread's pool, so a frame can be checked
+    // against the pool it came from.
+    static const void* current() {
+        return &local();
+    }
+
+private:
+    struct free_block {
+        free_block* next;
+    };
+
+    struct state {
+        alignas(std::max_align_t) unsigned char buffer[capacity];
+        std::size_t used;
+        std::size_t heap_allocations;
+        free_block* free[max_frame / granularity];
+    };
+
+    static_assert(std::is_trivially_destructible<state>::value, "frame_pool state must outlive thread exit");
+
+    static std::size_t size_class(std::size_t n) {
+        return n == 0 ? 0 : (n - 1) / granularity;
+    }
+
+    static state& local() {
+        static thread_local state s;
+        return s;
+    }
+};
+
+// either_awaiter is what co_await on an either produces inside a co_either
+// coroutine. Holder is an lvalue reference to the awaited either, or the
+// either itself when awaiting a temporary (which is then moved from).
+// Whether T is, or derives from, an either, and so is awaited through
+// either_awaiter rather than as it is.
+template <typename L, typename R>
+std::true_type derives_from_either(const either<L, R>*);
+std::false_type derives_from_either(const void*);
+
+template <typename T>
+using is_either_based = decltype(derives_from_either(static_cast<const std::remove_cvref_t<T>*>(nullptr)));
+
+template <typename Holder>
+struct either_awaiter {
+    using either_type = typename std::remove_cv<typename std::remove_reference<Holder>::type>::type;
+    static constexpr bool moves = !std::is_lvalue_reference<Holder>::value;
+
+    Holder e;
+
+    bool await_ready() const noexcept {
+        return e.is_left();
+    }
+
+    template <typename promise>
+    void await_suspend(std::coroutine_handle<promise> h) {
+        if constexpr (moves) {
+            h.promise().return_right(std::move(e.right_ref()));
+        } else {
+            h.promise().return_right(e.as_right());
+        }
+    }
+
+    // A left from a temporary is returned by value so that binding the
+    // result of co_await to a reference cannot dangle.
+    using result_type = typename std::conditional<moves,
+                                                  typename std::decay<decltype(e.as_left())>::type,
+                                                  decltype(e.as_left())>::type;
+
+    result_type await_resume() {
+        if constexpr (moves) {
+            return std::move(e.left_ref());
+        } else {
+            return e.as_left();
+        }
+    }
+};
+
+} // namespace detail
+
+// co_either is the return type of a coroutine that produces an
+// either<left_type, right_type>. Inside such a coroutine, `co_await e` on an
+// either (or on another co_either call) evaluates to e's left value, or ends
+// the coroutine with e's right value as its result; `co_return` sets the
+// result directly. A right awaited from a temporary is moved, not copied,
+// into the caller's result. Any other awaitable, such as a task_result, is
+// awaited as it is; if it suspends, the co_either must not be converted
+// until the coroutine has finished.
+//
+// The coroutine runs to completion before the call returns, and a co_either
+// converts to the either it computed:
+//
+//     ben::co_either<int, error> parse_pair(const char* in) {
+//         int a = co_await parse_int(in);
+//         int b = co_await parse_int(in + 4);
+//         co_return a + b;
+//     }
+//     ben::either<int, error> r = parse_pair(text);
+//
+// Frames come from a per-thread pool (see detail::frame_pool) rather than
+// the heap, so a co_either must be converted or destroyed on the thread that
+// called the coroutine; moving it to another thread is not supported, and
+// debug builds assert against it. Exceptions escaping the body are rethrown
+// on conversion.
+template <typename left_type, typename right_type>
+class co_either {
+public:
+    using value_type = either<left_type, right_type>;
+
+    struct promise_type {
+        promise_type() {}
+        ~promise_type() {
+            if (has_result_) {
+                result_.~value_type();
+            }
+        }
+
+        static void* operator new(std::size_t n) {
+            return detail::frame_pool::allocate(n);
+        }
+        static void operator delete(void* p, std::size_t n) noexcept {
+            detail::frame_pool::deallocate(p, n);
+        }
+
+        co_either get_return_object() {
+            return co_either(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+        std::suspend_always final_suspend() noexcept {
+            return {};
+        }
+        void unhandled_exception() {
+            exception_ = std::current_exception();
+        }
+
+        template <typename U>
+        void return_value(U&& value) {
+            ::new (&result_) value_type(std::forward<U>(value));
+            has_result_ = true;
+        }
+
+        template <typename U>
+        void return_right(U&& err) {
+            if constexpr (std::is_same<typename std::decay<U>::type, right_type>::value) {
+                ::new (&result_) value_type(std::forward<U>(err));
+            } else {
+                ::new (&result_) value_type(static_cast<right_type>(std::forward<U>(err)));
+            }
+            has_result_ = true;
+        }
+
+        template <typename L, typename R>
+        detail::either_awaiter<either<L, R>&> await_transform(either<L, R>& e) {
+            return {e};
+        }
+        template <typename L, typename R>
+        detail::either_awaiter<const either<L, R>&> await_transform(const either<L, R>& e) {
+            return {e};
+        }
+        template <typename L, typename R>
+        detail::either_awaiter<either<L, R>&&> await_transform(either<L, R>&& e) {
+            return {std::move(e)};
+        }
+        template <typename L, typename R>
+        detail::either_awaiter<either<L, R>> await_transform(co_either<L, R>&& c) {
+            return {std::move(c).get()};
+        }
+        template <typename Awaitable>
+            requires(!detail::is_either_based<Awaitable>::value)
+        Awaitable&& await_transform(Awaitable&& a) {
+            return std::forward<Awaitable>(a);
+        }
+
+    private:
+        friend class co_either;
+
+        bool has_result_ = false;
+        const void* pool_ = detail::frame_pool::current();
+        std::exception_ptr exception_;
+        union {
+            value_type result_;
+        };
+    };
+
+    co_either(co_either&& other) noexcept : handle_(other.handle_) {
+        other.handle_ = nullptr;
+    }
+    co_either(const co_either&) = delete;
+    co_either& operator=(const co_either&) = delete;
+    co_either& operator=(co_either&&) = delete;
+
+    ~co_either() {
+        if (handle_) {
+            assert_home_thread();
+            handle_.destroy();
+        }
+    }
+
+    // get moves the computed either out and releases the frame.
+    value_type get() && {
+        assert_home_thread();
+        promise_type& p = handle_.promise();
+        assert((p.has_result_ || p.exception_) && "co_either converted before its coroutine finished");
+        if (p.exception_) {
+            std::rethrow_exception(p.exception_);
+        }
+        value_type out(std::move(p.result_));
+        handle_.destroy();
+        handle_ = nullptr;
+        return out;
+    }
+
+    operator value_type() && {
+        return std::move(*this).get();
+    }
+
+private:
+    explicit co_either(std::coroutine_handle<promise_type> h) : handle_(h) {}
+
+    void assert_home_thread() const {
+        assert(handle_.promise().pool_ == detail::frame_pool::current() &&
+               "co_either used on a thread other than the one that created it");
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+} // namespace ben
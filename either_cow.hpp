@@ -0,0 +1,171 @@
+#pragma once
+
+#if __cplusplus < 201703L
+#error "either_cow.hpp requires C++17 (std::string_view)"
+#endif
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "either.hpp"
+
+namespace ben {
+
+// buffer_view is a read-only view of a contiguous array, the borrowed form of
+// a std::vector in a cow. It is std::span<const T> for C++17.
+template <typename T>
+class buffer_view {
+public:
+    using value_type = T;
+    using const_iterator = const T*;
+
+    constexpr buffer_view() = default;
+    constexpr buffer_view(const T* data, std::size_t size) : data_(data), size_(size) {}
+    template <typename Alloc>
+    buffer_view(const std::vector<T, Alloc>& v) : data_(v.data()), size_(v.size()) {}
+
+    constexpr const T* data() const {
+        return data_;
+    }
+    constexpr std::size_t size() const {
+        return size_;
+    }
+    constexpr bool empty() const {
+        return size_ == 0;
+    }
+    constexpr const T* begin() const {
+        return data_;
+    }
+    constexpr const T* end() const {
+        return data_ + size_;
+    }
+    constexpr const T& operator[](std::size_t i) const {
+        return data_[i];
+    }
+
+private:
+    const T* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+// cow_traits<T> names the borrowed form of an owned type T and how to view
+// and copy it. It is provided for std::basic_string and std::vector;
+// specialize it to use cow with other owned buffers.
+template <typename T>
+struct cow_traits;
+
+template <typename C, typename Traits, typename Alloc>
+struct cow_traits<std::basic_string<C, Traits, Alloc>> {
+    using view_type = std::basic_string_view<C, Traits>;
+
+    static view_type view(const std::basic_string<C, Traits, Alloc>& owned) {
+        return owned;
+    }
+    static std::basic_string<C, Traits, Alloc> to_owned(view_type v) {
+        return std::basic_string<C, Traits, Alloc>(v);
+    }
+};
+
+template <typename T, typename Alloc>
+struct cow_traits<std::vector<T, Alloc>> {
+    using view_type = buffer_view<T>;
+
+    static view_type view(const std::vector<T, Alloc>& owned) {
+        return owned;
+    }
+    static std::vector<T, Alloc> to_owned(view_type v) {
+        return std::vector<T, Alloc>(v.begin(), v.end());
+    }
+};
+
+// cow<T> is either a borrowed view of someone else's data or an owned T, for
+// functions that usually return their input untouched but sometimes have to
+// build a new value (unescaping, normalizing, decompressing). Readers see one
+// view type whichever alternative is held; the owned form is only
+// materialized, by copying the borrowed data, when the caller asks to mutate.
+//
+// A borrowed cow does not extend the lifetime of the data it views.
+template <typename T>
+class cow {
+public:
+    using owned_type = T;
+    using view_type = typename cow_traits<T>::view_type;
+
+    // A view, or a C string or string literal for a string cow, converts
+    // implicitly and is borrowed. Owning is explicit, since building from a
+    // const T& copies the data.
+    cow(view_type borrowed) : e_(borrowed) {}
+    template <typename C, typename = std::enable_if_t<std::is_constructible_v<view_type, const C*>>>
+    cow(const C* borrowed) : e_(view_type(borrowed)) {}
+    explicit cow(T&& owned) : e_(std::move(owned)) {}
+    explicit cow(const T& owned) : e_(owned) {}
+
+    bool is_borrowed() const {
+        return e_.is_left();
+    }
+    bool is_owned() const {
+        return e_.is_right();
+    }
+
+    // view() reads the data whichever alternative is held. For an owned cow
+    // the view is invalidated by mutation and by destroying the cow.
+    view_type view() const {
+        return e_.is_left() ? e_.as_left() : cow_traits<T>::view(e_.as_right());
+    }
+    operator view_type() const {
+        return view();
+    }
+
+    auto data() const {
+        return view().data();
+    }
+    std::size_t size() const {
+        return view().size();
+    }
+    bool empty() const {
+        return view().empty();
+    }
+
+    // to_mut() gives mutable access to an owned T, copying the borrowed data
+    // into one first if needed.
+    T& to_mut() {
+        if (e_.is_left()) {
+            e_ = cow_traits<T>::to_owned(e_.as_left());
+        }
+        return e_.right_ref();
+    }
+
+    // into_owned() moves the owned T out, copying the borrowed data if
+    // needed.
+    T into_owned() && {
+        if (e_.is_left()) {
+            return cow_traits<T>::to_owned(e_.as_left());
+        }
+        return std::move(e_.right_ref());
+    }
+
+    // Compares the viewed data, so a borrowed and an owned cow holding the
+    // same bytes are equal.
+    bool operator==(const cow& other) const {
+        const view_type a = view();
+        const view_type b = other.view();
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < a.size(); i++) {
+            if (!(a[i] == b[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    either<view_type, T> e_;
+};
+
+} // namespace ben
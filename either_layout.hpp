@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
+
+#include "either.hpp"
+
+namespace ben {
+
+namespace detail {
+
+constexpr std::size_t max_size(std::size_t a, std::size_t b) {
+    return a > b ? a : b;
+}
+
+constexpr std::size_t round_up(std::size_t n, std::size_t align) {
+    return (n + align - 1) / align * align;
+}
+
+// The layout of an either stored as a Tag followed by a union of A and B,
+// which is how either<L, R> and most of its specializations are laid out.
+template <typename Either, typename Tag, typename A, typename B>
+struct tagged_union_layout {
+    static constexpr std::size_t size = sizeof(Either);
+    static constexpr std::size_t align = alignof(Either);
+    static constexpr std::size_t tag_offset = 0;
+    static constexpr std::size_t tag_size = sizeof(Tag);
+    static constexpr std::size_t payload_offset = round_up(sizeof(Tag), max_size(alignof(A), alignof(B)));
+    static constexpr std::size_t payload_size = max_size(sizeof(A), sizeof(B));
+    static constexpr std::size_t padding = size - tag_size - payload_size;
+    static constexpr bool uses_niche = false;
+
+    static_assert(payload_offset + round_up(payload_size, max_size(alignof(A), alignof(B))) == size,
+                  "either is not laid out as a tag followed by a union");
+};
+
+// The layout of an either that keeps its tag in spare bits of a Payload,
+// such as the low bit of an aligned pointer.
+template <typename Either, typename Payload>
+struct niche_layout {
+    static constexpr std::size_t size = sizeof(Either);
+    static constexpr std::size_t align = alignof(Either);
+    static constexpr std::size_t tag_offset = 0;
+    static constexpr std::size_t tag_size = 0;
+    static constexpr std::size_t payload_offset = 0;
+    static constexpr std::size_t payload_size = sizeof(Payload);
+    static constexpr std::size_t padding = size - payload_size;
+    static constexpr bool uses_niche = true;
+};
+
+} // namespace detail
+
+// either_layout<L, R> describes how either<L, R> is laid out, in bytes:
+//
+//   size, align       sizeof and alignof the either
+//   tag_offset        where the tag starts
+//   tag_size          how wide the tag is; 0 when it lives in a niche
+//   payload_offset    where the alternatives start
+//   payload_size      the size of the larger alternative
+//   padding           bytes that hold neither the tag nor the larger
+//                     alternative, i.e. what alignment costs
+//   uses_niche        whether the tag is packed into spare bits of the
+//                     payload instead of having bytes of its own
+//
+// Headers that give either a layout of its own (either_cold.hpp) specialize
+// it to match.
+template <typename left_type, typename right_type>
+struct either_layout
+    : detail::tagged_union_layout<either<left_type, right_type>,
+                                  decltype(detail::either_storage_t<left_type, right_type>::left_),
+                                  left_type, right_type> {};
+
+template <typename left_type, typename right_type>
+struct either_layout<left_type&, right_type&>
+    : std::conditional<alignof(left_type) >= 2 && alignof(right_type) >= 2,
+                       detail::niche_layout<either<left_type&, right_type&>, std::uintptr_t>,
+                       detail::tagged_union_layout<either<left_type&, right_type&>, bool, left_type*,
+                                                   right_type*>>::type {};
+
+// is_size_optimal<L, R> holds when either<L, R> takes no more room than its
+// larger alternative plus one byte of tag (or no more than the alternative,
+// when the tag is in a niche), which is what a byte-packed layout would
+// take. Meant for static_assert on types whose size matters:
+//
+//   static_assert(ben::is_size_optimal<char, std::array<char, 7>>::value, "");
+template <typename left_type, typename right_type>
+struct is_size_optimal
+    : std::integral_constant<bool, either_layout<left_type, right_type>::size <=
+                                       either_layout<left_type, right_type>::payload_size +
+                                           (either_layout<left_type, right_type>::uses_niche ? 0 : 1)> {};
+
+// write_either_layout prints one line describing either<L, R> under name,
+// for layout audits.
+template <typename left_type, typename right_type>
+void write_either_layout(std::FILE* out, const char* name) {
+    using layout = either_layout<left_type, right_type>;
+    std::fprintf(out, "%-40s size %3zu align %2zu tag %zu+%zu payload %zu+%zu padding %3zu%s%s\n", name,
+                 layout::size, layout::align, layout::tag_offset, layout::tag_size, layout::payload_offset,
+                 layout::payload_size, layout::padding, layout::uses_niche ? " niche" : "",
+                 is_size_optimal<left_type, right_type>::value ? " optimal" : "");
+}
+
+} // namespace ben
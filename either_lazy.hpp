@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+#include "either.hpp"
+
+namespace ben {
+
+// lazy_either holds either a value of type T or a callable F that produces
+// one. The first get() calls F and emplaces its result over the callable, so
+// a lazy value costs no more space than either<T, F> and needs no separate
+// optional or allocation. If F throws, the callable is kept and the next
+// get() tries again.
+//
+// lazy_either is not safe to share between threads while unevaluated; use
+// lazy_once for that.
+template <typename T, typename F>
+class lazy_either {
+public:
+    static_assert(std::is_convertible<decltype(std::declval<F&>()()), T>::value,
+                  "calling F must produce a T");
+
+    lazy_either(const T& value) : e_(value) {}
+    lazy_either(T&& value) : e_(std::move(value)) {}
+    lazy_either(F fn) : e_(std::move(fn)) {}
+
+    bool is_ready() const {
+        return e_.is_left();
+    }
+
+    T& get() {
+        if (!e_.is_left()) {
+            // The cast finishes building the T before the callable is
+            // destroyed, in case F returns a reference into itself.
+            e_.emplace_left(static_cast<T>(e_.right_ref()()));
+        }
+        return e_.left_ref();
+    }
+
+    T& operator*() {
+        return get();
+    }
+    T* operator->() {
+        return &get();
+    }
+
+private:
+    either<T, F> e_;
+};
+
+// lazy_once is a lazy_either whose get() may be called from several threads
+// at once: F runs exactly once (or again only after a call that threw), and
+// every caller sees its result. Once the value is ready, get() is one
+// acquire load. It is neither copyable nor movable, like std::once_flag.
+template <typename T, typename F>
+class lazy_once {
+public:
+    static_assert(std::is_convertible<decltype(std::declval<F&>()()), T>::value,
+                  "calling F must produce a T");
+
+    lazy_once(const T& value) : e_(value), ready_(true) {}
+    lazy_once(T&& value) : e_(std::move(value)), ready_(true) {}
+    lazy_once(F fn) : e_(std::move(fn)), ready_(false) {}
+
+    lazy_once(const lazy_once&) = delete;
+    lazy_once& operator=(const lazy_once&) = delete;
+
+    bool is_ready() const {
+        return ready_.load(std::memory_order_acquire);
+    }
+
+    const T& get() const {
+        if (!ready_.load(std::memory_order_acquire)) {
+            materialize();
+        }
+        return e_.as_left();
+    }
+
+    const T& operator*() const {
+        return get();
+    }
+    const T* operator->() const {
+        return &get();
+    }
+
+private:
+    void materialize() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!ready_.load(std::memory_order_relaxed)) {
+            e_.emplace_left(static_cast<T>(e_.right_ref()()));
+            ready_.store(true, std::memory_order_release);
+        }
+    }
+
+    mutable either<T, F> e_;
+    mutable std::atomic<bool> ready_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace ben
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+#include "either.hpp"
+#include "either_relocate.hpp"
+
+#if defined(__GNUC__)
+#define BEN_EXPECT(x, v) __builtin_expect(!!(x), (v))
+#else
+#define BEN_EXPECT(x, v) (x)
+#endif
+
+namespace ben {
+
+enum class either_hint {
+    left,
+    right,
+};
+
+// either_likely is an either<left_type, right_type> that tells the compiler
+// which alternative to expect: is_left() and is_right(), and so visit(),
+// branch with __builtin_expect toward hint, which lays the expected path out
+// as the fall-through. It is an either in every other respect and converts
+// to and from one, so a profile (see either_profile.hpp) can be fed back by
+// changing a type at the sites that are heavily one-sided.
+template <typename left_type, typename right_type, either_hint hint>
+class either_likely : public either<left_type, right_type> {
+    using base = either<left_type, right_type>;
+
+public:
+    using base::base;
+    using base::operator=;
+
+    constexpr either_likely(const base& other) : base(other) {}
+    constexpr either_likely(base&& other) : base(std::move(other)) {}
+
+    constexpr bool is_left(BEN_PROFILE_SITE) const {
+        return BEN_EXPECT(base::is_left(BEN_PROFILE_SITE_ARGS), hint == either_hint::left);
+    }
+    constexpr bool is_right(BEN_PROFILE_SITE) const {
+        return BEN_EXPECT(base::is_right(BEN_PROFILE_SITE_ARGS), hint == either_hint::right);
+    }
+};
+
+template <typename left_type, typename right_type, either_hint hint>
+struct is_trivially_relocatable<either_likely<left_type, right_type, hint>>
+    : is_trivially_relocatable<either<left_type, right_type>> {};
+
+} // namespace ben
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "either_relocate.hpp"
+
+namespace ben {
+
+namespace detail {
+
+// Layout of a nan_either word. A left is the bit pattern of its double, with
+// every NaN replaced by nan_canonical. A right is nan_right_tag with the
+// right value in the low 48 bits. nan_right_tag is a negative quiet NaN that
+// no canonicalized double can have, and it is the numerically largest
+// pattern in use, so telling the two apart is a single unsigned compare.
+constexpr std::uint64_t nan_canonical = 0x7ff8000000000000ull;
+constexpr std::uint64_t nan_right_tag = 0xfffc000000000000ull;
+constexpr std::uint64_t nan_payload_mask = 0x0000ffffffffffffull;
+
+inline std::uint64_t nan_box_double(double d) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    return d != d ? nan_canonical : bits;
+}
+
+inline double nan_unbox_double(std::uint64_t bits) {
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+// 1 if bits holds a right, else 0. Equivalent to bits >= nan_right_tag, but
+// written with shifts and adds only, because SSE2 has no 64-bit compare and
+// the bulk loops below would otherwise not vectorize.
+inline std::uint64_t nan_right_bit(std::uint64_t bits) {
+    return ((bits >> 50) + 1) >> 14;
+}
+
+template <typename T, bool = std::is_pointer<T>::value>
+struct nan_payload {
+    static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= 6,
+                  "nan_either right_type must be a pointer or a trivially copyable type of at most 48 bits");
+
+    static std::uint64_t encode(T v) {
+        std::uint64_t bits = 0;
+        std::memcpy(&bits, &v, sizeof(T));
+        return bits;
+    }
+    static T decode(std::uint64_t bits) {
+        T v;
+        std::memcpy(&v, &bits, sizeof(T));
+        return v;
+    }
+};
+
+// Pointers must fit in 48 bits, which holds for user-space addresses on
+// x86-64 and AArch64.
+template <typename T>
+struct nan_payload<T, true> {
+    static_assert(sizeof(T) == sizeof(std::uint64_t), "nan_either pointer payloads need 64-bit pointers");
+
+    static std::uint64_t encode(T v) {
+        const std::uint64_t bits = reinterpret_cast<std::uintptr_t>(v);
+        assert((bits & ~nan_payload_mask) == 0 && "pointer does not fit in 48 bits");
+        return bits;
+    }
+    static T decode(std::uint64_t bits) {
+        return reinterpret_cast<T>(static_cast<std::uintptr_t>(bits));
+    }
+};
+
+} // namespace detail
+
+// nan_either is an either<double, right_type> packed into one 64-bit word by
+// NaN boxing: doubles are stored as themselves and rights hide in the payload
+// of a NaN pattern that real doubles never use. It is half the size of
+// either<double, right_type>. right_type is a pointer (whose address fits in
+// 48 bits) or a trivially copyable type of up to 6 bytes, such as a uint32_t
+// handle.
+//
+// Storing a NaN left canonicalizes it, so its sign and payload are not
+// preserved. Since no double or right object exists in the word, as_left()
+// and as_right() return by value, and there is no left_ref()/right_ref().
+template <typename left_type, typename right_type>
+class nan_either {
+    static_assert(std::is_same<left_type, double>::value, "nan_either boxes a double on the left");
+    using payload = detail::nan_payload<right_type>;
+
+public:
+    nan_either(double input) : bits_(detail::nan_box_double(input)) {}
+    nan_either(right_type input) : bits_(detail::nan_right_tag | payload::encode(input)) {}
+
+    nan_either& operator=(double other) {
+        bits_ = detail::nan_box_double(other);
+        return *this;
+    }
+    nan_either& operator=(right_type other) {
+        bits_ = detail::nan_right_tag | payload::encode(other);
+        return *this;
+    }
+
+    double as_left() const {
+        return detail::nan_unbox_double(bits_);
+    }
+    right_type as_right() const {
+        return payload::decode(bits_ & detail::nan_payload_mask);
+    }
+
+    bool is_left() const {
+        return bits_ < detail::nan_right_tag;
+    }
+    bool is_right() const {
+        return !is_left();
+    }
+
+    // Lefts compare as doubles (so NaN != NaN and 0.0 == -0.0), rights by
+    // value.
+    bool operator==(const nan_either& other) const {
+        if (is_left() && other.is_left()) {
+            return as_left() == other.as_left();
+        }
+        return bits_ == other.bits_;
+    }
+
+    // The raw word, for serialization and bulk processing.
+    std::uint64_t bits() const {
+        return bits_;
+    }
+
+private:
+    std::uint64_t bits_;
+};
+
+template <typename left_type, typename right_type>
+struct is_trivially_relocatable<nan_either<left_type, right_type>> : std::true_type {};
+
+// Bulk operations over arrays of nan_either. Each is a branch-free loop over
+// the words, which the compiler can vectorize (sum_left only when allowed to
+// reassociate floating-point adds). A right's word is masked to zero, which
+// is the bit pattern of 0.0.
+
+// box_doubles writes each of in[0, n) into out as a left.
+template <typename right_type>
+void box_doubles(const double* in, std::size_t n, nan_either<double, right_type>* out) {
+    for (std::size_t i = 0; i < n; i++) {
+        out[i] = in[i];
+    }
+}
+
+// unbox_lefts writes each left of in[0, n) to out, and fill for each right.
+template <typename right_type>
+void unbox_lefts(const nan_either<double, right_type>* in, std::size_t n, double* out, double fill) {
+    const std::uint64_t fill_bits = detail::nan_box_double(fill);
+    for (std::size_t i = 0; i < n; i++) {
+        const std::uint64_t bits = in[i].bits();
+        const std::uint64_t left_mask = detail::nan_right_bit(bits) - 1;
+        out[i] = detail::nan_unbox_double((bits & left_mask) | (fill_bits & ~left_mask));
+    }
+}
+
+template <typename right_type>
+std::size_t count_left(const nan_either<double, right_type>* in, std::size_t n) {
+    std::uint64_t rights = 0;
+    for (std::size_t i = 0; i < n; i++) {
+        rights += detail::nan_right_bit(in[i].bits());
+    }
+    return n - static_cast<std::size_t>(rights);
+}
+
+// sum_left adds up the lefts of in[0, n), ignoring rights.
+template <typename right_type>
+double sum_left(const nan_either<double, right_type>* in, std::size_t n) {
+    double sum = 0;
+    for (std::size_t i = 0; i < n; i++) {
+        const std::uint64_t bits = in[i].bits();
+        sum += detail::nan_unbox_double(bits & (detail::nan_right_bit(bits) - 1));
+    }
+    return sum;
+}
+
+} // namespace ben
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "either.hpp"
+#include "either_layout.hpp"
+
+namespace ben {
+
+// packed_either is an either of two trivially copyable types with no
+// alignment at all: a tag byte followed by the bytes of the larger
+// alternative, so packed_either<std::uint8_t, std::uint64_t> is 9 bytes
+// where either is 16. It is meant for wire formats and for dense arrays
+// where memory, not access time, is what runs out. Values are copied in
+// and out with memcpy, so accessors return by value rather than by
+// reference. Unused payload bytes are kept zero, so two packed eithers
+// holding the same value have the same bytes.
+template <typename left_type, typename right_type>
+class packed_either {
+public:
+    static_assert(std::is_trivially_copyable<left_type>::value && std::is_trivially_copyable<right_type>::value,
+                  "packed_either needs trivially copyable alternatives");
+
+    packed_either(const left_type& input) : bytes_() {
+        set_left(input);
+    }
+    packed_either(const right_type& input) : bytes_() {
+        set_right(input);
+    }
+    explicit packed_either(const either<left_type, right_type>& input) : bytes_() {
+        if (input.is_left()) {
+            set_left(input.as_left());
+        } else {
+            set_right(input.as_right());
+        }
+    }
+
+    bool is_left() const {
+        return bytes_[0] != 0;
+    }
+    bool is_right() const {
+        return bytes_[0] == 0;
+    }
+
+    left_type left() const {
+        left_type out;
+        std::memcpy(&out, bytes_ + 1, sizeof(left_type));
+        return out;
+    }
+    right_type right() const {
+        right_type out;
+        std::memcpy(&out, bytes_ + 1, sizeof(right_type));
+        return out;
+    }
+
+    void set_left(const left_type& value) {
+        std::memset(bytes_ + 1 + sizeof(left_type), 0, payload_size - sizeof(left_type));
+        std::memcpy(bytes_ + 1, &value, sizeof(left_type));
+        bytes_[0] = 1;
+    }
+    void set_right(const right_type& value) {
+        std::memset(bytes_ + 1 + sizeof(right_type), 0, payload_size - sizeof(right_type));
+        std::memcpy(bytes_ + 1, &value, sizeof(right_type));
+        bytes_[0] = 0;
+    }
+
+    either<left_type, right_type> to_either() const {
+        return is_left() ? either<left_type, right_type>(left()) : either<left_type, right_type>(right());
+    }
+
+    bool operator==(const packed_either& other) const {
+        return is_left() == other.is_left() && (is_left() ? left() == other.left() : right() == other.right());
+    }
+
+private:
+    static constexpr std::size_t payload_size = sizeof(left_type) > sizeof(right_type) ? sizeof(left_type)
+                                                                                        : sizeof(right_type);
+
+    unsigned char bytes_[1 + payload_size];
+};
+
+namespace detail {
+
+template <typename L, typename R>
+void unpack_scalar(const packed_either<L, R>* src, std::size_t n, either<L, R>* dst) {
+    for (std::size_t i = 0; i < n; i++) {
+        dst[i] = src[i].to_either();
+    }
+}
+
+// The vector path needs an either that is exactly one 16-byte register with
+// a one-byte bool tag at the front, such as either<std::uint8_t,
+// std::uint64_t>; not one under zero_either_padding, whose tag is wider.
+template <typename L, typename R>
+using can_unpack_sse2 = std::integral_constant<bool,
+    either_layout<L, R>::size == 16 && either_layout<L, R>::tag_size == 1 &&
+    std::is_same<decltype(either_storage_t<L, R>::left_), bool>::value &&
+    std::is_trivially_copyable<either<L, R>>::value>;
+
+#if defined(__SSE2__)
+// Each packed either is loaded whole into a register; the tag byte is kept
+// where it is and the payload shifted from offset 1 up to payload_offset, so
+// one load, two shifts, an and, an or and one store convert it. The 16-byte
+// load reads past the end of a packed either, so the last few elements, whose
+// load would run off the end of src, take the scalar path.
+template <typename L, typename R>
+void unpack_impl(const packed_either<L, R>* src, std::size_t n, either<L, R>* dst, std::true_type) {
+    constexpr int payload_offset = static_cast<int>(either_layout<L, R>::payload_offset);
+    const __m128i tag_mask = _mm_cvtsi32_si128(0xff);
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(src);
+    unsigned char* out = reinterpret_cast<unsigned char*>(dst);
+    const unsigned char* const in_end = in + n * sizeof(packed_either<L, R>);
+    std::size_t i = 0;
+    for (; in_end - in >= 16; i++) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        const __m128i payload = _mm_slli_si128(_mm_srli_si128(x, 1), payload_offset);
+        const __m128i tag = _mm_and_si128(x, tag_mask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_or_si128(tag, payload));
+        in += sizeof(packed_either<L, R>);
+        out += sizeof(either<L, R>);
+    }
+    unpack_scalar(src + i, n - i, dst + i);
+}
+#endif
+
+template <typename L, typename R, typename Vector>
+void unpack_impl(const packed_either<L, R>* src, std::size_t n, either<L, R>* dst, Vector) {
+    unpack_scalar(src, n, dst);
+}
+
+} // namespace detail
+
+// unpack converts n packed eithers at src into the eithers at dst, which must
+// already hold values (any values). With SSE2, eithers that fill one 16-byte
+// register, such as either<std::uint8_t, std::uint64_t>, are converted a
+// register at a time; others element by element.
+template <typename L, typename R>
+void unpack(const packed_either<L, R>* src, std::size_t n, either<L, R>* dst) {
+#if defined(__SSE2__)
+    detail::unpack_impl(src, n, dst, detail::can_unpack_sse2<L, R>{});
+#else
+    detail::unpack_scalar(src, n, dst);
+#endif
+}
+
+// pack is the other direction: n eithers at src into the packed eithers at
+// dst.
+template <typename L, typename R>
+void pack(const either<L, R>* src, std::size_t n, packed_either<L, R>* dst) {
+    for (std::size_t i = 0; i < n; i++) {
+        dst[i] = packed_either<L, R>(src[i]);
+    }
+}
+
+} // namespace ben
@@ -0,0 +1,184 @@
+#pragma once
+
+// Call-site profiling of either dispatch. Building with BEN_EITHER_PROFILE
+// defined gives is_left(), is_right() and ben::visit() hidden default
+// arguments holding the caller's file and line, and each call counts whether
+// the either held a left or a right at that site. The counts are written out
+// at exit, busiest site first, to the file named by the
+// BEN_EITHER_PROFILE_OUT environment variable, or to stderr. Sites that are
+// nearly always one way are candidates for either_likely.
+//
+// Calls made inside the library (operator==, the combinators and so on) are
+// counted at their own line in either.ipp. Counting costs a hash lookup per
+// call, so this is for profiling builds only.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ben {
+
+struct profile_site {
+    const char* file;
+    unsigned line;
+    std::uint64_t left;
+    std::uint64_t right;
+};
+
+namespace detail {
+
+struct profile_key {
+    const char* file;
+    unsigned line;
+
+    bool operator==(const profile_key& other) const {
+        return file == other.file && line == other.line;
+    }
+};
+
+struct profile_key_hash {
+    std::size_t operator()(const profile_key& k) const {
+        return std::hash<const void*>()(k.file) ^ (std::size_t{k.line} * 0x9e3779b97f4a7c15ull);
+    }
+};
+
+struct profile_tally {
+    std::uint64_t left = 0;
+    std::uint64_t right = 0;
+};
+
+using profile_map = std::unordered_map<profile_key, profile_tally, profile_key_hash>;
+
+// Counts from threads that have exited, or that asked for a snapshot. It is
+// written out when it is destroyed at exit.
+class profile_registry {
+public:
+    static profile_registry& instance() {
+        static profile_registry r;
+        return r;
+    }
+
+    void merge(profile_map& local) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& site : local) {
+            profile_tally& t = sites_[site.first];
+            t.left += site.second.left;
+            t.right += site.second.right;
+        }
+        local.clear();
+    }
+
+    // The same file can reach the map under several pointers (one per
+    // translation unit), so sites are combined by file name here.
+    std::vector<profile_site> snapshot() {
+        std::vector<profile_site> out;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& site : sites_) {
+                out.push_back({site.first.file, site.first.line, site.second.left, site.second.right});
+            }
+        }
+        std::sort(out.begin(), out.end(), [](const profile_site& a, const profile_site& b) {
+            const int c = std::strcmp(a.file, b.file);
+            return c != 0 ? c < 0 : a.line < b.line;
+        });
+        std::vector<profile_site> merged;
+        for (const profile_site& s : out) {
+            if (!merged.empty() && merged.back().line == s.line && std::strcmp(merged.back().file, s.file) == 0) {
+                merged.back().left += s.left;
+                merged.back().right += s.right;
+            } else {
+                merged.push_back(s);
+            }
+        }
+        std::stable_sort(merged.begin(), merged.end(), [](const profile_site& a, const profile_site& b) {
+            return a.left + a.right > b.left + b.right;
+        });
+        return merged;
+    }
+
+    ~profile_registry();
+
+private:
+    profile_registry() = default;
+
+    std::mutex mutex_;
+    profile_map sites_;
+};
+
+// Each thread counts into its own map without locking, and hands the counts
+// to the registry when it exits. Touching the registry first makes sure it
+// is destroyed, and reports, after every thread's map has been merged.
+struct profile_local {
+    profile_local() {
+        profile_registry::instance();
+    }
+    ~profile_local() {
+        profile_registry::instance().merge(sites);
+    }
+    profile_map sites;
+};
+
+inline profile_local& profile_thread() {
+    static thread_local profile_local local;
+    return local;
+}
+
+inline void profile_record(const char* file, unsigned line, bool left) {
+    profile_tally& t = profile_thread().sites[profile_key{file, line}];
+    if (left) {
+        t.left++;
+    } else {
+        t.right++;
+    }
+}
+
+} // namespace detail
+
+// either_profile_snapshot returns the counts recorded so far by exited
+// threads and the calling thread, busiest site first.
+inline std::vector<profile_site> either_profile_snapshot() {
+    detail::profile_registry& r = detail::profile_registry::instance();
+    r.merge(detail::profile_thread().sites);
+    return r.snapshot();
+}
+
+// write_either_profile prints one line per site: the counts, the share of
+// lefts, and the hint either_likely would want if one side has at least 90%.
+inline void write_either_profile(std::FILE* out, const std::vector<profile_site>& sites) {
+    std::fprintf(out, "%-48s %12s %12s %7s  %s\n", "site", "left", "right", "left%", "hint");
+    for (const profile_site& s : sites) {
+        const double total = static_cast<double>(s.left + s.right);
+        const double pct = total == 0 ? 0 : 100.0 * static_cast<double>(s.left) / total;
+        const char* hint = pct >= 90 ? "left" : pct <= 10 ? "right" : "-";
+        char where[48];
+        const char* slash = std::strrchr(s.file, '/');
+        std::snprintf(where, sizeof(where), "%s:%u", slash != nullptr ? slash + 1 : s.file, s.line);
+        std::fprintf(out, "%-48s %12llu %12llu %6.1f%%  %s\n", where, static_cast<unsigned long long>(s.left),
+                     static_cast<unsigned long long>(s.right), pct, hint);
+    }
+}
+
+inline detail::profile_registry::~profile_registry() {
+    const std::vector<profile_site> sites = snapshot();
+    if (sites.empty()) {
+        return;
+    }
+    const char* path = std::getenv("BEN_EITHER_PROFILE_OUT");
+    std::FILE* out = path != nullptr ? std::fopen(path, "w") : stderr;
+    if (out == nullptr) {
+        return;
+    }
+    write_either_profile(out, sites);
+    if (out != stderr) {
+        std::fclose(out);
+    }
+}
+
+} // namespace ben
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "either_relocate.hpp"
+
+namespace ben {
+
+namespace detail {
+
+// pointer_alternative describes an alternative that ptr_either can hold:
+// a raw T* (not owned) or a std::unique_ptr<T> (owned, deleted on
+// destruction). T must be aligned to at least 2 so the low bit of its
+// address is free for the tag.
+template <typename P>
+struct pointer_alternative;
+
+template <typename T>
+struct pointer_alternative<T*> {
+    using element_type = T;
+    static constexpr bool owning = false;
+
+    static T* into_raw(T* p) {
+        return p;
+    }
+    static T* from_raw(T* p) {
+        return p;
+    }
+    static void destroy(T*) {}
+};
+
+template <typename T>
+struct pointer_alternative<std::unique_ptr<T>> {
+    static_assert(!std::is_array<T>::value, "ptr_either does not hold unique_ptr to arrays");
+    using element_type = T;
+    static constexpr bool owning = true;
+
+    static T* into_raw(std::unique_ptr<T>&& p) {
+        return p.release();
+    }
+    static std::unique_ptr<T> from_raw(T* p) {
+        return std::unique_ptr<T>(p);
+    }
+    static void destroy(T* p) {
+        std::default_delete<T>{}(p);
+    }
+};
+
+// borrowed_ptr is a non-owning view of a pointer held by a ptr_either,
+// returned where the primary either would return a reference to a
+// unique_ptr. It offers the observers of unique_ptr and converts to T*.
+template <typename T>
+class borrowed_ptr {
+public:
+    explicit borrowed_ptr(T* p) : p_(p) {}
+
+    T* get() const {
+        return p_;
+    }
+    T& operator*() const {
+        return *p_;
+    }
+    T* operator->() const {
+        return p_;
+    }
+    explicit operator bool() const {
+        return p_ != nullptr;
+    }
+    operator T*() const {
+        return p_;
+    }
+
+private:
+    T* p_;
+};
+
+template <typename P>
+using borrowed_t = typename std::conditional<pointer_alternative<P>::owning,
+                                             borrowed_ptr<typename pointer_alternative<P>::element_type>,
+                                             P>::type;
+
+// The word holding pointer and tag. When neither alternative owns its
+// pointee this is trivially copyable; otherwise it is move-only and deletes
+// the owned pointee on destruction.
+template <typename left_type, typename right_type,
+          bool = pointer_alternative<left_type>::owning || pointer_alternative<right_type>::owning>
+class ptr_either_word {
+protected:
+    explicit ptr_either_word(std::uintptr_t bits) : bits_(bits) {}
+
+    void destroy_pointee() {}
+
+    std::uintptr_t bits_;
+};
+
+template <typename left_type, typename right_type>
+class ptr_either_word<left_type, right_type, true> {
+public:
+    ptr_either_word(ptr_either_word&& other) noexcept : bits_(other.bits_) {
+        other.bits_ &= 1;
+    }
+    ptr_either_word& operator=(ptr_either_word&& other) noexcept {
+        if (this != &other) {
+            destroy_pointee();
+            bits_ = other.bits_;
+            other.bits_ &= 1;
+        }
+        return *this;
+    }
+    ~ptr_either_word() {
+        destroy_pointee();
+    }
+
+protected:
+    explicit ptr_either_word(std::uintptr_t bits) : bits_(bits) {}
+
+    void destroy_pointee() {
+        using lp = typename pointer_alternative<left_type>::element_type*;
+        using rp = typename pointer_alternative<right_type>::element_type*;
+        if (bits_ & 1) {
+            pointer_alternative<right_type>::destroy(reinterpret_cast<rp>(bits_ & ~std::uintptr_t{1}));
+        } else {
+            pointer_alternative<left_type>::destroy(reinterpret_cast<lp>(bits_));
+        }
+    }
+
+    std::uintptr_t bits_;
+};
+
+} // namespace detail
+
+// ptr_either is an either of two pointer-like alternatives, each a raw T* or
+// a std::unique_ptr<T>, stored as a single pointer with the tag in its low
+// bit: it is the size of one pointer where either<A*, B*> is two. Pointees
+// must be at least 2-byte aligned, and null is a valid value for either side.
+//
+// The accessors mirror either's, but since no real pointer object exists,
+// as_left()/as_right() return the pointer by value (or, for a unique_ptr
+// alternative, a borrowed_ptr with get(), * and ->), and left_ref()/
+// right_ref() return a proxy that can be read, assigned, reset or released.
+// unique_ptr alternatives keep their ownership: the pointee is deleted when
+// replaced or when the ptr_either is destroyed, and such a ptr_either is
+// move-only.
+template <typename left_type, typename right_type>
+class ptr_either : private detail::ptr_either_word<left_type, right_type> {
+    using left_alt = detail::pointer_alternative<left_type>;
+    using right_alt = detail::pointer_alternative<right_type>;
+    using left_pointer = typename left_alt::element_type*;
+    using right_pointer = typename right_alt::element_type*;
+    using base = detail::ptr_either_word<left_type, right_type>;
+
+public:
+    // A proxy for one side's pointer, returned by left_ref()/right_ref().
+    template <typename alt_type, bool right>
+    class slot {
+    public:
+        using pointer = typename detail::pointer_alternative<alt_type>::element_type*;
+
+        pointer get() const {
+            return owner_.template raw<pointer>();
+        }
+        operator pointer() const {
+            return get();
+        }
+        typename detail::pointer_alternative<alt_type>::element_type& operator*() const {
+            return *get();
+        }
+        pointer operator->() const {
+            return get();
+        }
+        explicit operator bool() const {
+            return get() != nullptr;
+        }
+
+        // Replaces the held pointer, deleting the old pointee if owned.
+        slot& operator=(alt_type p) {
+            owner_ = ptr_either(std::move(p), std::integral_constant<bool, right>{});
+            return *this;
+        }
+        void reset(pointer p = nullptr) {
+            *this = detail::pointer_alternative<alt_type>::from_raw(p);
+        }
+        // Gives up ownership of the pointee, leaving null behind.
+        pointer release() {
+            pointer p = get();
+            owner_.bits_ &= 1;
+            return p;
+        }
+
+    private:
+        friend class ptr_either;
+        explicit slot(ptr_either& owner) : owner_(owner) {}
+
+        ptr_either& owner_;
+    };
+
+    using left_slot = slot<left_type, false>;
+    using right_slot = slot<right_type, true>;
+
+    ptr_either(left_type input) : ptr_either(std::move(input), std::false_type{}) {}
+    ptr_either(right_type input) : ptr_either(std::move(input), std::true_type{}) {}
+
+    ptr_either& operator=(left_type other) {
+        *this = ptr_either(std::move(other));
+        return *this;
+    }
+    ptr_either& operator=(right_type other) {
+        *this = ptr_either(std::move(other));
+        return *this;
+    }
+
+    detail::borrowed_t<left_type> as_left() const {
+        return detail::borrowed_t<left_type>(raw<left_pointer>());
+    }
+    detail::borrowed_t<right_type> as_right() const {
+        return detail::borrowed_t<right_type>(raw<right_pointer>());
+    }
+
+    left_slot left_ref() {
+        return left_slot(*this);
+    }
+    right_slot right_ref() {
+        return right_slot(*this);
+    }
+
+    // take_left/take_right move the held pointer out as its alternative type
+    // (transferring ownership for unique_ptr), leaving null behind.
+    left_type take_left() {
+        return left_alt::from_raw(left_ref().release());
+    }
+    right_type take_right() {
+        return right_alt::from_raw(right_ref().release());
+    }
+
+    bool is_left() const {
+        return (this->bits_ & 1) == 0;
+    }
+    bool is_right() const {
+        return !is_left();
+    }
+
+    bool operator==(const ptr_either& other) const {
+        return this->bits_ == other.bits_;
+    }
+
+private:
+    // Every value is built by one of these two, so the alignment the tag bit
+    // relies on is checked here rather than at class scope, where it would
+    // stop a ptr_either from naming a type that is still being defined, as
+    // in struct node { ptr_either<node*, leaf*> child; }.
+    ptr_either(left_type&& p, std::false_type)
+        : base(reinterpret_cast<std::uintptr_t>(left_alt::into_raw(std::move(p)))) {
+        static_assert(alignof(typename left_alt::element_type) >= 2, "left pointee must be aligned to at least 2");
+    }
+    ptr_either(right_type&& p, std::true_type)
+        : base(reinterpret_cast<std::uintptr_t>(right_alt::into_raw(std::move(p))) | 1) {
+        static_assert(alignof(typename right_alt::element_type) >= 2, "right pointee must be aligned to at least 2");
+    }
+
+    template <typename pointer>
+    pointer raw() const {
+        return reinterpret_cast<pointer>(this->bits_ & ~std::uintptr_t{1});
+    }
+};
+
+template <typename left_type, typename right_type>
+struct is_trivially_relocatable<ptr_either<left_type, right_type>> : std::true_type {};
+
+} // namespace ben
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "either.hpp"
+
+namespace ben {
+
+// is_trivially_relocatable<T> is true when moving a T to new storage and
+// destroying the source is equivalent to copying its bytes and forgetting the
+// source. That holds for every trivially copyable type, and for many types
+// that own resources through a plain pointer; specialize it for your own.
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template <typename T>
+struct is_trivially_relocatable<const T> : is_trivially_relocatable<T> {};
+
+template <typename T>
+struct is_trivially_relocatable<std::unique_ptr<T, std::default_delete<T>>> : std::true_type {};
+
+template <typename T, std::size_t N>
+struct is_trivially_relocatable<std::array<T, N>> : is_trivially_relocatable<T> {};
+
+template <typename left_type, typename right_type>
+struct is_trivially_relocatable<either<left_type, right_type>>
+    : std::integral_constant<bool, is_trivially_relocatable<left_type>::value &&
+                                   is_trivially_relocatable<right_type>::value> {};
+
+template <typename left_type, typename right_type>
+struct is_trivially_relocatable<either<left_type&, right_type&>> : std::true_type {};
+
+namespace detail {
+
+template <typename T>
+T* relocate_range(T* first, T* last, T* d_first, std::true_type) {
+    const std::size_t n = static_cast<std::size_t>(last - first);
+    if (n != 0) {
+        std::memcpy(static_cast<void*>(d_first), static_cast<const void*>(first), n * sizeof(T));
+    }
+    return d_first + n;
+}
+
+template <typename T>
+T* relocate_range(T* first, T* last, T* d_first, std::false_type) {
+    T* d = d_first;
+    try {
+        for (; first != last; ++first, ++d) {
+            ::new (static_cast<void*>(d)) T(std::move(*first));
+            first->~T();
+        }
+    } catch (...) {
+        // The element being moved was not relocated; destroy it and
+        // everything after it, plus whatever already reached d_first.
+        for (; first != last; ++first) {
+            first->~T();
+        }
+        for (T* p = d_first; p != d; ++p) {
+            p->~T();
+        }
+        throw;
+    }
+    return d;
+}
+
+} // namespace detail
+
+// uninitialized_relocate moves the objects in [first, last) into the
+// uninitialized storage at d_first and ends the lifetime of the originals,
+// returning the end of the destination range. For trivially relocatable T
+// this is one memcpy; otherwise each element is move constructed and its
+// source destroyed. If that throws, both ranges are destroyed. The ranges
+// must not overlap.
+template <typename T>
+T* uninitialized_relocate(T* first, T* last, T* d_first) {
+    return detail::relocate_range(first, last, d_first, is_trivially_relocatable<T>{});
+}
+
+// relocate_at relocates the single object at src into the uninitialized
+// storage at dst.
+template <typename T>
+T* relocate_at(T* src, T* dst) {
+    return uninitialized_relocate(src, src + 1, dst) - 1;
+}
+
+} // namespace ben
@@ -0,0 +1,145 @@
+#pragma once
+
+#if __cplusplus < 201703L
+#error "either_std.hpp requires C++17 (std::variant and std::optional)"
+#endif
+
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#if __has_include(<expected>)
+#include <expected>
+#endif
+
+#include "either.hpp"
+
+// Conversions between ben::either and the standard sum types. Each comes in a
+// const& flavour that copies the held alternative and a && flavour that
+// moves it, and each builds the target's alternative directly from the
+// source's, so there is no intermediate copy. For trivially copyable
+// alternatives they compile to a copy of the tag and the value (see
+// codegen/codegen_interop.cpp).
+//
+// The layouts of std::variant and std::expected are not specified, so there
+// is no bytewise conversion; the member-wise one is as cheap wherever the
+// layouts happen to agree.
+
+namespace ben {
+
+// to_variant returns a std::variant<left_type, right_type> holding the left
+// at index 0 or the right at index 1.
+template <typename left_type, typename right_type>
+std::variant<left_type, right_type> to_variant(const either<left_type, right_type>& e) {
+    if (e.is_left()) {
+        return std::variant<left_type, right_type>(std::in_place_index<0>, e.as_left());
+    }
+    return std::variant<left_type, right_type>(std::in_place_index<1>, e.as_right());
+}
+
+template <typename left_type, typename right_type>
+std::variant<left_type, right_type> to_variant(either<left_type, right_type>&& e) {
+    if (e.is_left()) {
+        return std::variant<left_type, right_type>(std::in_place_index<0>, std::move(e.left_ref()));
+    }
+    return std::variant<left_type, right_type>(std::in_place_index<1>, std::move(e.right_ref()));
+}
+
+// from_variant is the inverse of to_variant. It throws
+// std::bad_variant_access if the variant is valueless by exception.
+template <typename left_type, typename right_type>
+either<left_type, right_type> from_variant(const std::variant<left_type, right_type>& v) {
+    if (v.valueless_by_exception()) {
+        throw std::bad_variant_access();
+    }
+    if (v.index() == 0) {
+        return either<left_type, right_type>(*std::get_if<0>(&v));
+    }
+    return either<left_type, right_type>(*std::get_if<1>(&v));
+}
+
+template <typename left_type, typename right_type>
+either<left_type, right_type> from_variant(std::variant<left_type, right_type>&& v) {
+    if (v.valueless_by_exception()) {
+        throw std::bad_variant_access();
+    }
+    if (v.index() == 0) {
+        return either<left_type, right_type>(std::move(*std::get_if<0>(&v)));
+    }
+    return either<left_type, right_type>(std::move(*std::get_if<1>(&v)));
+}
+
+// to_optional returns the left value, or nullopt if e holds a right, which is
+// discarded.
+template <typename left_type, typename right_type>
+std::optional<left_type> to_optional(const either<left_type, right_type>& e) {
+    if (e.is_left()) {
+        return std::optional<left_type>(std::in_place, e.as_left());
+    }
+    return std::nullopt;
+}
+
+template <typename left_type, typename right_type>
+std::optional<left_type> to_optional(either<left_type, right_type>&& e) {
+    if (e.is_left()) {
+        return std::optional<left_type>(std::in_place, std::move(e.left_ref()));
+    }
+    return std::nullopt;
+}
+
+// from_optional returns the value of o as a left, or if o is empty, the right
+// built from if_empty. right_type is given explicitly:
+// from_optional<error>(o, error::missing).
+template <typename right_type, typename left_type, typename U>
+either<left_type, right_type> from_optional(const std::optional<left_type>& o, U&& if_empty) {
+    if (o.has_value()) {
+        return either<left_type, right_type>(*o);
+    }
+    return either<left_type, right_type>(right_type(std::forward<U>(if_empty)));
+}
+
+template <typename right_type, typename left_type, typename U>
+either<left_type, right_type> from_optional(std::optional<left_type>&& o, U&& if_empty) {
+    if (o.has_value()) {
+        return either<left_type, right_type>(std::move(*o));
+    }
+    return either<left_type, right_type>(right_type(std::forward<U>(if_empty)));
+}
+
+#if defined(__cpp_lib_expected)
+// With C++23, to_expected maps the left to the expected value and the right
+// to the error, and from_expected is its inverse.
+template <typename left_type, typename right_type>
+std::expected<left_type, right_type> to_expected(const either<left_type, right_type>& e) {
+    if (e.is_left()) {
+        return std::expected<left_type, right_type>(std::in_place, e.as_left());
+    }
+    return std::expected<left_type, right_type>(std::unexpect, e.as_right());
+}
+
+template <typename left_type, typename right_type>
+std::expected<left_type, right_type> to_expected(either<left_type, right_type>&& e) {
+    if (e.is_left()) {
+        return std::expected<left_type, right_type>(std::in_place, std::move(e.left_ref()));
+    }
+    return std::expected<left_type, right_type>(std::unexpect, std::move(e.right_ref()));
+}
+
+template <typename left_type, typename right_type>
+either<left_type, right_type> from_expected(const std::expected<left_type, right_type>& x) {
+    if (x.has_value()) {
+        return either<left_type, right_type>(*x);
+    }
+    return either<left_type, right_type>(x.error());
+}
+
+template <typename left_type, typename right_type>
+either<left_type, right_type> from_expected(std::expected<left_type, right_type>&& x) {
+    if (x.has_value()) {
+        return either<left_type, right_type>(std::move(*x));
+    }
+    return either<left_type, right_type>(std::move(x.error()));
+}
+#endif // __cpp_lib_expected
+
+} // namespace ben
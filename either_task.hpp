@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
+
+#include "either.hpp"
+
+namespace ben {
+
+// continuation is the intrusive record for work waiting on a task_result.
+// It lives with the waiter (a callback object, or a coroutine's awaiter in
+// its frame) and is linked into the executor's queue when the result is
+// ready, so neither waiting nor scheduling allocates.
+struct continuation {
+    void (*run)(continuation* self) = nullptr;
+    continuation* next = nullptr;
+};
+
+// local_executor is a single-threaded FIFO of ready continuations. Results
+// completed inside a continuation queue their waiters rather than running
+// them recursively, so long chains do not grow the stack.
+class local_executor {
+public:
+    local_executor() = default;
+    local_executor(const local_executor&) = delete;
+    local_executor& operator=(const local_executor&) = delete;
+
+    void post(continuation& c) {
+        c.next = nullptr;
+        if (tail_ == nullptr) {
+            head_ = &c;
+        } else {
+            tail_->next = &c;
+        }
+        tail_ = &c;
+    }
+
+    // run executes queued continuations, including any they queue, until
+    // none are left, and returns how many ran.
+    std::size_t run() {
+        std::size_t n = 0;
+        while (head_ != nullptr) {
+            continuation* c = head_;
+            head_ = c->next;
+            if (head_ == nullptr) {
+                tail_ = nullptr;
+            }
+            c->run(c);
+            n++;
+        }
+        return n;
+    }
+
+    bool empty() const {
+        return head_ == nullptr;
+    }
+
+private:
+    continuation* head_ = nullptr;
+    continuation* tail_ = nullptr;
+};
+
+// callback is a continuation that calls a stored F with no arguments.
+template <typename F>
+class callback : public continuation {
+public:
+    explicit callback(F f) : f_(std::move(f)) {
+        run = [](continuation* self) {
+            static_cast<callback*>(self)->f_();
+        };
+    }
+    callback(const callback&) = delete;
+    callback& operator=(const callback&) = delete;
+
+private:
+    F f_;
+};
+
+// task_result is the single-threaded, allocation-free counterpart of a
+// std::promise/std::future pair: one object, placed wherever the producer
+// and consumer can both reach it (typically the awaiting frame), that is
+// first pending and later holds a value or an error. Its state is an
+// either of the result, either<T, E>, and the pending state, which is the
+// continuation to schedule on completion (or null if nobody waits yet).
+//
+// A task_result completes once, and waiters and completers refer to it by
+// address, so it cannot be copied or moved. As with either<T, E>, T and E
+// must differ.
+template <typename T, typename E>
+class task_result {
+public:
+    using result_type = either<T, E>;
+
+    explicit task_result(local_executor& ex) : state_(static_cast<continuation*>(nullptr)), ex_(&ex) {}
+    task_result(const task_result&) = delete;
+    task_result& operator=(const task_result&) = delete;
+
+    bool is_ready() const {
+        return state_.is_left();
+    }
+
+    // set_value and set_error complete the result and queue its waiter, if
+    // any, on the executor.
+    void set_value(T value) {
+        complete(std::move(value));
+    }
+    void set_error(E error) {
+        complete(std::move(error));
+    }
+
+    // then registers c to be queued when the result is ready, or queues it
+    // now if it already is. Only one continuation may wait at a time, and it
+    // must stay alive until it has run.
+    void then(continuation& c) {
+        if (is_ready()) {
+            ex_->post(c);
+            return;
+        }
+        assert(state_.as_right() == nullptr && "task_result already has a waiter");
+        state_.right_ref() = &c;
+    }
+
+    // The result; only valid once is_ready().
+    result_type& get() & {
+        return state_.left_ref();
+    }
+    const result_type& get() const& {
+        return state_.as_left();
+    }
+    result_type&& get() && {
+        return std::move(state_.left_ref());
+    }
+
+#if defined(__cpp_impl_coroutine)
+    // With C++20, co_await on a task_result suspends until it is ready and
+    // resumes on its executor, yielding the result. The awaiter, and so the
+    // continuation, lives in the awaiting coroutine's frame.
+    class awaiter : private continuation {
+    public:
+        explicit awaiter(task_result& r) : r_(r) {}
+
+        bool await_ready() const {
+            return r_.is_ready();
+        }
+        void await_suspend(std::coroutine_handle<> h) {
+            h_ = h;
+            run = [](continuation* self) {
+                static_cast<awaiter*>(self)->h_.resume();
+            };
+            r_.then(*this);
+        }
+        result_type& await_resume() const {
+            return r_.get();
+        }
+
+    private:
+        task_result& r_;
+        std::coroutine_handle<> h_;
+    };
+
+    awaiter operator co_await() {
+        return awaiter(*this);
+    }
+#endif
+
+private:
+    // Completing overwrites the waiter pointer with the result, so the
+    // waiter is read out first.
+    template <typename U>
+    void complete(U&& result) {
+        assert(!is_ready() && "task_result completed twice");
+        continuation* waiter = state_.as_right();
+        state_.emplace_left(std::forward<U>(result));
+        if (waiter != nullptr) {
+            ex_->post(*waiter);
+        }
+    }
+
+    either<result_type, continuation*> state_;
+    local_executor* ex_;
+};
+
+} // namespace ben
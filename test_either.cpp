@@ -1,10 +1,43 @@
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "either.hpp"
+#include "either_algorithm.hpp"
+#include "either_cold.hpp"
+// This file is where the common explicit instantiations are compiled, which
+// checks that every member of those eithers instantiates.
+#define BEN_EITHER_INSTANTIATE_COMMON
+#include "either_common.hpp"
+#include "either_layout.hpp"
+#include "either_lazy.hpp"
+#include "either_likely.hpp"
+#include "either_nan.hpp"
+#include "either_packed.hpp"
+#include "either_ptr.hpp"
+#include "either_relocate.hpp"
+#include "either_task.hpp"
+#if __cplusplus >= 201703L
+#include "either_arena.hpp"
+#include "either_array.hpp"
+#include "either_cow.hpp"
+#include "either_std.hpp"
+#endif
+#if __cplusplus >= 202002L
+#include "either_coro.hpp"
+#endif
 #include "lest.hpp"
 
 #define CASE(name) lest_CASE(specification, name)
@@ -578,6 +611,1573 @@ CASE("test invalid zero state") {
     ben::either<slow_t, fast_t> quux(std::move(foo));
 }
 
+CASE("partition indices") {
+    std::vector<ben::either<int, char>> v;
+    for (int i = 0; i < 150; i++) {
+        if (i % 3 == 0) {
+            v.emplace_back('x');
+        } else {
+            v.emplace_back(i);
+        }
+    }
+    std::vector<size_t> left(v.size());
+    std::vector<size_t> right(v.size());
+    const size_t nl = ben::partition_indices(v.data(), v.size(), left.data(), right.data());
+    EXPECT(nl == 100u);
+    for (size_t i = 0; i < nl; i++) {
+        EXPECT(v[left[i]].is_left());
+        EXPECT(left[i] % 3 != 0);
+    }
+    for (size_t i = 0; i < v.size() - nl; i++) {
+        EXPECT(v[right[i]].is_right());
+        EXPECT(right[i] == i * 3);
+    }
+}
+
+CASE("batch visit") {
+    std::vector<ben::either<int, char>> v;
+    int expected = 0;
+    for (int i = 0; i < 1000; i++) {
+        if ((i * 7919) % 5 < 2) {
+            v.emplace_back('a');
+        } else {
+            v.emplace_back(i);
+            expected += i;
+        }
+    }
+    int sum = 0;
+    size_t rights = 0;
+    ben::batch_visit(v.data(), v.size(), [&](int& l) { sum += l; l = -1; }, [&](char& r) { rights += r == 'a'; });
+    EXPECT(sum == expected);
+    EXPECT(rights == 400u);
+    const ben::either<int, char>* cv = v.data();
+    size_t lefts = 0;
+    ben::batch_visit(cv, v.size(), [&](const int& l) { lefts += l == -1; }, [](const char&) {});
+    EXPECT(lefts == 600u);
+}
+
+namespace {
+
+struct sample {
+    std::int32_t value;
+
+    bool operator==(const sample& other) const {
+        return value == other.value;
+    }
+};
+
+} // namespace
+
+namespace ben {
+template <>
+struct zero_either_padding<sample, char> : std::true_type {};
+} // namespace ben
+
+CASE("zeroed padding makes equal eithers equal bytewise") {
+    using zeroed = ben::either<sample, char>;
+    static_assert(sizeof(zeroed) == 8, "");
+    static_assert(ben::either_layout<sample, char>::tag_size == 4, "");
+    static_assert(ben::either_layout<sample, char>::padding == 0, "");
+    static_assert(std::is_trivially_copyable<zeroed>::value, "");
+#if defined(BEN_HAS_UNIQUE_REPRESENTATIONS)
+    static_assert(ben::is_bitwise_comparable<sample, char>::value, "");
+#endif
+    static_assert(!ben::is_bitwise_comparable<int, char>::value, "");
+
+    const zeroed fresh('c');
+    zeroed e(sample{-1});
+    e = 'c';
+    EXPECT(std::memcmp(&e, &fresh, sizeof(zeroed)) == 0);
+    e.emplace_left(sample{-1});
+    e.emplace_right('c');
+    EXPECT(std::memcmp(&e, &fresh, sizeof(zeroed)) == 0);
+    zeroed l(sample{-1});
+    zeroed r('c');
+    l.swap(r);
+    EXPECT(std::memcmp(&l, &fresh, sizeof(zeroed)) == 0);
+    const zeroed copy = l;
+    EXPECT(std::memcmp(&copy, &fresh, sizeof(zeroed)) == 0);
+}
+
+CASE("bulk equal and mismatch") {
+    std::vector<ben::either<sample, char>> a;
+    for (int i = 0; i < 3000; i++) {
+        if (i % 4 == 0) {
+            a.emplace_back('r');
+        } else {
+            a.emplace_back(sample{i});
+        }
+    }
+    std::vector<ben::either<sample, char>> b = a;
+    EXPECT(ben::equal(a.data(), b.data(), a.size()));
+    EXPECT(ben::mismatch(a.data(), b.data(), a.size()) == a.size());
+    b[2077] = 'r';
+    EXPECT(!ben::equal(a.data(), b.data(), a.size()));
+    EXPECT(ben::mismatch(a.data(), b.data(), a.size()) == 2077u);
+    b[5] = sample{5 + 256};
+    EXPECT(ben::mismatch(a.data(), b.data(), a.size()) == 5u);
+    EXPECT(ben::mismatch(a.data(), b.data(), 5) == 5u);
+
+    std::vector<ben::either<int, std::string>> x = {1, std::string("two"), 3};
+    std::vector<ben::either<int, std::string>> y = x;
+    EXPECT(ben::equal(x.data(), y.data(), x.size()));
+    y[1] = std::string("deux");
+    EXPECT(ben::mismatch(x.data(), y.data(), x.size()) == 1u);
+}
+
+CASE("map left and map right") {
+    ben::either<int, std::string> l = 2;
+    ben::either<int, std::string> r = std::string("err");
+    auto twice = [](int x) { return x * 2.5; };
+    auto len = [](const std::string& s) { return s.size(); };
+
+    ben::either<double, std::string> ml = l.map_left(twice);
+    EXPECT(ml.is_left());
+    EXPECT(ml.as_left() == 5.0);
+    ben::either<double, std::string> mr = r.map_left(twice);
+    EXPECT(mr.is_right());
+    EXPECT(mr.as_right() == "err");
+
+    ben::either<int, size_t> rl = l.map_right(len);
+    EXPECT(rl.is_left());
+    EXPECT(rl.as_left() == 2);
+    ben::either<int, size_t> rr = r.map_right(len);
+    EXPECT(rr.is_right());
+    EXPECT(rr.as_right() == 3u);
+}
+
+CASE("combinators move through rvalue chains") {
+    using slow_t = std::unique_ptr<int>;
+    using result = ben::either<slow_t, std::string>;
+    auto make = [](int v) -> result { return std::make_unique<int>(v); };
+    auto bump = [](slow_t p) { (*p)++; return p; };
+
+    result r = make(1).map_left(bump).map_left(bump).and_then([](slow_t p) -> result {
+        if (*p > 2) {
+            return std::string("too big");
+        }
+        return p;
+    });
+    EXPECT(r.is_right());
+    EXPECT(r.as_right() == "too big");
+
+    result ok = make(0).map_left(bump).and_then([](slow_t p) -> result { return p; });
+    EXPECT(ok.is_left());
+    EXPECT(*ok.as_left() == 1);
+
+    slow_t out = make(7).value_or(nullptr);
+    EXPECT(*out == 7);
+    slow_t fallback = result(std::string("e")).value_or(nullptr);
+    EXPECT(fallback == nullptr);
+}
+
+CASE("map in place keeps the type") {
+    int c = 0;
+    {
+        ben::either<destruct_counter, int> e(destruct_counter{&c});
+        auto same = std::move(e).map_left([](destruct_counter d) { return d; });
+        EXPECT(same.is_left());
+        EXPECT(c == 0);
+        ben::either<destruct_counter, int> r = 4;
+        auto doubled = std::move(r).map_right([](int x) { return x * 2; });
+        EXPECT(doubled.is_right());
+        EXPECT(doubled.as_right() == 8);
+    }
+    EXPECT(c == 1);
+
+    // Only construction is needed, not assignment.
+    struct fixed {
+        const int v;
+    };
+    static_assert(!std::is_move_assignable<fixed>::value, "");
+    auto l = ben::either<fixed, int>(fixed{1}).map_left([](fixed f) { return fixed{f.v + 1}; });
+    EXPECT(l.as_left().v == 2);
+    auto r = ben::either<int, fixed>(fixed{1}).map_right([](fixed f) { return fixed{f.v * 3}; });
+    EXPECT(r.as_right().v == 3);
+}
+
+CASE("or else and value or") {
+    ben::either<int, std::string> r = std::string("bad");
+    ben::either<int, std::string> l = 3;
+    auto recover = [](const std::string& s) -> ben::either<int, char> { return static_cast<int>(s.size()); };
+    auto recovered = r.or_else(recover);
+    EXPECT(recovered.is_left());
+    EXPECT(recovered.as_left() == 3);
+    auto kept = l.or_else(recover);
+    EXPECT(kept.is_left());
+    EXPECT(kept.as_left() == 3);
+    EXPECT(l.value_or(9) == 3);
+    EXPECT(r.value_or(9) == 9);
+
+    int touched = 0;
+    l.map_left([&](int& x) { x = 10; touched++; return x; });
+    EXPECT(l.as_left() == 10);
+    EXPECT(touched == 1);
+}
+
+CASE("converting construction moves the held alternative") {
+    ben::either<int, std::string> narrow = std::string(64, 'x');
+    const char* data = narrow.as_right().data();
+    ben::either<long, std::string> wide = std::move(narrow);
+    EXPECT(wide.is_right());
+    EXPECT(wide.as_right().data() == data);
+
+    const ben::either<int, std::string> l = 7;
+    ben::either<long, std::string> copied = l;
+    EXPECT(copied.is_left());
+    EXPECT(copied.as_left() == 7L);
+
+    ben::either<std::unique_ptr<int>, int> owned = std::unique_ptr<int>(new int(3));
+    ben::either<std::shared_ptr<int>, long> shared = std::move(owned);
+    EXPECT(*shared.as_left() == 3);
+}
+
+CASE("converting construction is explicit unless both sides convert") {
+    using from = ben::either<int, std::size_t>;
+    static_assert(std::is_convertible<from, ben::either<long, std::size_t>>::value, "");
+    static_assert(!std::is_convertible<from, ben::either<int, std::vector<std::string>>>::value, "");
+    static_assert(std::is_constructible<ben::either<int, std::vector<std::string>>, from>::value, "");
+    static_assert(!std::is_constructible<ben::either<int, int*>, from>::value, "");
+    static_assert(!std::is_convertible<ben::either<std::unique_ptr<int>, int>,
+                                       ben::either<int*, int>>::value, "");
+    // The reference and cold specializations store their alternatives in
+    // their own way and are not converted from.
+    static_assert(!std::is_constructible<ben::either<long, int>, ben::either<int&, char&>>::value, "");
+    static_assert(!std::is_constructible<ben::either<long, int>, const ben::either<int&, char&>&>::value, "");
+    static_assert(!std::is_assignable<ben::either<long, int>&, ben::either<int&, char&>>::value, "");
+    static_assert(!std::is_constructible<ben::either<long, std::string>,
+                                         ben::either<int, ben::cold<std::string>>>::value, "");
+
+    const from r = std::size_t{2};
+    ben::either<int, std::vector<std::string>> e(r);
+    EXPECT(e.is_right());
+    EXPECT(e.as_right().size() == 2u);
+}
+
+CASE("converting assignment") {
+    ben::either<long, std::string> e = 1L;
+    e = ben::either<int, std::string>(2);
+    EXPECT(e.as_left() == 2L);
+    e = ben::either<int, std::string>(std::string("abc"));
+    EXPECT(e.is_right());
+    EXPECT(e.as_right() == "abc");
+    const ben::either<int, const char*> r = "def";
+    e = r;
+    EXPECT(e.as_right() == "def");
+    e = ben::either<short, std::string>(short{4});
+    EXPECT(e.is_left());
+    EXPECT(e.as_left() == 4L);
+}
+
+struct throwing_move {
+    throwing_move(int v) : v_(v) {}
+    throwing_move(const throwing_move&) = default;
+    throwing_move(throwing_move&& other) noexcept(false) : v_(other.v_) {}
+    throwing_move& operator=(const throwing_move&) = default;
+    throwing_move& operator=(throwing_move&& other) noexcept(false) {
+        v_ = other.v_;
+        return *this;
+    }
+    int v_;
+};
+
+CASE("swap covers all four tag combinations") {
+    using either_t = ben::either<std::string, std::vector<int>>;
+    either_t a = std::string("a");
+    either_t b = std::string("b");
+    a.swap(b);
+    EXPECT(a.as_left() == "b");
+    EXPECT(b.as_left() == "a");
+
+    either_t c = std::vector<int>{1};
+    either_t d = std::vector<int>{2, 3};
+    swap(c, d);
+    EXPECT(c.as_right().size() == 2u);
+    EXPECT(d.as_right().size() == 1u);
+
+    a.swap(c);
+    EXPECT(a.is_right());
+    EXPECT(a.as_right().size() == 2u);
+    EXPECT(c.is_left());
+    EXPECT(c.as_left() == "b");
+
+    c.swap(a);
+    EXPECT(c.is_right());
+    EXPECT(a.is_left());
+    EXPECT(a.as_left() == "b");
+
+    static_assert(noexcept(a.swap(b)), "");
+}
+
+CASE("swap with throwing moves goes through a temporary") {
+    using either_t = ben::either<throwing_move, int>;
+    static_assert(!noexcept(std::declval<either_t&>().swap(std::declval<either_t&>())), "");
+    either_t a = throwing_move(1);
+    either_t b = 2;
+    a.swap(b);
+    EXPECT(a.as_right() == 2);
+    EXPECT(b.as_left().v_ == 1);
+}
+
+CASE("algorithms swap eithers through adl") {
+    std::vector<ben::either<std::string, int>> v;
+    for (int i = 0; i < 5; i++) {
+        if (i % 2 == 0) {
+            v.emplace_back(std::string(1, static_cast<char>('a' + i)));
+        } else {
+            v.emplace_back(i);
+        }
+    }
+    std::reverse(v.begin(), v.end());
+    EXPECT(v[0].as_left() == "e");
+    EXPECT(v[1].as_right() == 3);
+    EXPECT(v[4].as_left() == "a");
+
+    int x = 1;
+    std::string s = "s";
+    ben::either<int&, std::string&> r1 = x;
+    ben::either<int&, std::string&> r2 = s;
+    swap(r1, r2);
+    EXPECT(&r1.as_right() == &s);
+    EXPECT(&r2.as_left() == &x);
+}
+
+CASE("visit dispatches on the held alternative") {
+    ben::either<std::string, int> e = std::string(40, 'v');
+    EXPECT(ben::visit(e, [](std::string& s) { return s.size(); }, [](int) { return std::size_t{0}; }) == 40u);
+    const ben::either<std::string, int> r = 3;
+    EXPECT(ben::visit(r, [](const std::string&) { return 0; }, [](const int& v) { return v; }) == 3);
+    const char* data = e.as_left().data();
+    std::string moved = ben::visit(std::move(e), [](std::string&& s) { return std::move(s); },
+                                   [](int&&) { return std::string(); });
+    EXPECT(moved.data() == data);
+}
+
+CASE("visit works on the reference and cold specializations") {
+    int x = 1;
+    std::string s = "s";
+    using refs_t = ben::either<int&, std::string&>;
+    refs_t l = x;
+    ben::visit(l, [](int& v) { v = 2; }, [](std::string&) {});
+    EXPECT(x == 2);
+    // An rvalue either of references still hands on the referent as an
+    // lvalue: it never owned it.
+    EXPECT(ben::visit(refs_t(s), [](int&) { return static_cast<std::string*>(nullptr); },
+                      [](std::string& v) { return &v; }) == &s);
+    const refs_t c = s;
+    EXPECT(ben::visit(c, [](int&) { return 0; }, [](std::string& v) { return static_cast<int>(v.size()); }) == 1);
+
+    using cold_t = ben::either<int, ben::cold<std::string>>;
+    cold_t e = std::string(40, 'c');
+    EXPECT(ben::visit(e, [](int&) { return std::size_t{0}; }, [](std::string& v) { return v.size(); }) == 40u);
+    const cold_t& ce = e;
+    EXPECT(ben::visit(ce, [](const int&) { return std::size_t{0}; },
+                      [](const std::string& v) { return v.size(); }) == 40u);
+    const char* data = e.as_right().data();
+    std::string moved = ben::visit(std::move(e), [](int&&) { return std::string(); },
+                                   [](std::string&& v) { return std::move(v); });
+    EXPECT(moved.data() == data);
+}
+
+CASE("either likely behaves as an either") {
+    using hinted = ben::either_likely<int, std::string, ben::either_hint::left>;
+    hinted h = 4;
+    EXPECT(h.is_left());
+    EXPECT(!h.is_right());
+    h = std::string("rare");
+    EXPECT(h.is_right());
+    EXPECT(ben::visit(h, [](int) { return 0; }, [](const std::string& s) { return static_cast<int>(s.size()); }) == 4);
+    ben::either<int, std::string> plain = h;
+    EXPECT(plain.as_right() == "rare");
+    hinted back = plain;
+    EXPECT(back == h);
+    static_assert(sizeof(hinted) == sizeof(ben::either<int, std::string>), "");
+}
+
+#if defined(BEN_EITHER_PROFILE)
+CASE("profiling counts hits per call site") {
+    using either_t = ben::either<int, std::string>;
+    const unsigned probe_line = __LINE__ + 1;
+    auto probe = [](const either_t& e) { return e.is_left(); };
+    const either_t l = 1;
+    const either_t r = std::string("r");
+    for (int i = 0; i < 9; i++) {
+        probe(l);
+    }
+    probe(r);
+    std::uint64_t left = 0;
+    std::uint64_t right = 0;
+    for (const ben::profile_site& site : ben::either_profile_snapshot()) {
+        if (site.line == probe_line && std::strcmp(site.file, __FILE__) == 0) {
+            left = site.left;
+            right = site.right;
+        }
+    }
+    EXPECT(left == 9u);
+    EXPECT(right == 1u);
+}
+#endif // BEN_EITHER_PROFILE
+
+CASE("emplace replaces the held value") {
+    ben::either<std::string, std::vector<int>> e = std::string("a");
+    e.emplace_right(3u, 7);
+    EXPECT(e.is_right());
+    EXPECT(e.as_right().size() == 3u);
+    EXPECT(e.emplace_left(2u, 'x') == "xx");
+    EXPECT(e.is_left());
+
+    // Construction that throws leaves the old value in place.
+    ben::either<int, std::vector<int>> v = 5;
+    EXPECT_THROWS(v.emplace_right(std::size_t(-1)));
+    EXPECT(v.is_left());
+    EXPECT(v.as_left() == 5);
+}
+
+// counted tracks how many are alive, so a test can tell a value destroyed
+// twice or never from one destroyed once. Copying one holding a negative
+// number throws, and so does moving it when moves_throw is set.
+template <bool moves_throw>
+struct counted {
+    static int live;
+
+    static void check(int v, bool throws) {
+        if (throws && v < 0) {
+            throw std::runtime_error("counted");
+        }
+    }
+
+    counted(int v) : v_(v) {
+        live++;
+    }
+    counted(const counted& other) : v_(other.v_) {
+        check(v_, true);
+        live++;
+    }
+    counted(counted&& other) noexcept(!moves_throw) : v_(other.v_) {
+        check(v_, moves_throw);
+        live++;
+    }
+    counted& operator=(const counted&) = default;
+    ~counted() {
+        live--;
+    }
+    int v_;
+};
+
+template <bool moves_throw>
+int counted<moves_throw>::live = 0;
+
+static_assert(ben::detail::replace_strategy_for<int, std::string, int>::value == ben::detail::replace_direct, "");
+static_assert(ben::detail::replace_strategy_for<counted<false>, std::string, const counted<false>&>::value ==
+                  ben::detail::replace_temp, "");
+static_assert(ben::detail::replace_strategy_for<counted<true>, std::string, const counted<true>&>::value ==
+                  ben::detail::replace_backup, "");
+static_assert(ben::detail::replace_strategy_for<counted<true>, counted<true>, const counted<true>&>::value ==
+                  ben::detail::replace_last, "");
+
+CASE("assignment that changes alternative keeps the old value on a throw") {
+    {
+        using either_t = ben::either<std::string, counted<false>>;
+        either_t e = std::string("keep");
+        const either_t bad = counted<false>(-1);
+        EXPECT_THROWS_AS(e = bad, std::runtime_error);
+        EXPECT(e.is_left());
+        EXPECT(e.as_left() == "keep");
+
+        e = either_t(counted<false>(1));
+        EXPECT(e.as_right().v_ == 1);
+        e = std::string("back");
+        EXPECT(e.as_left() == "back");
+    }
+    EXPECT(counted<false>::live == 0);
+
+    {
+        // Moving the new alternative may throw, so the old one is moved
+        // aside instead and put back.
+        using either_t = ben::either<std::string, counted<true>>;
+        either_t e = std::string(40, 'k');
+        either_t bad = counted<true>(1);
+        bad.right_ref().v_ = -1;
+        EXPECT_THROWS_AS(e = bad, std::runtime_error);
+        EXPECT(e.is_left());
+        EXPECT(e.as_left() == std::string(40, 'k'));
+
+        const either_t good = counted<true>(2);
+        e = good;
+        EXPECT(e.as_right().v_ == 2);
+    }
+    EXPECT(counted<true>::live == 0);
+}
+
+CASE("cold either keeps its right when a left fails to replace it") {
+    {
+        using either_t = ben::either<counted<true>, ben::cold<std::string>>;
+        either_t e = std::string(40, 'c');
+        either_t bad = counted<true>(1);
+        bad.left_ref().v_ = -1;
+        EXPECT_THROWS_AS(e = std::move(bad), std::runtime_error);
+        EXPECT(e.is_right());
+        EXPECT(e.as_right() == std::string(40, 'c'));
+
+        either_t good = counted<true>(2);
+        e = std::move(good);
+        EXPECT(e.as_left().v_ == 2);
+        e = std::string("r");
+        EXPECT(e.as_right() == "r");
+    }
+    EXPECT(counted<true>::live == 0);
+}
+
+CASE("emplace keeps the old value on a throw") {
+    {
+        ben::either<std::string, counted<true>> e = std::string("keep");
+        const counted<true> bad(-1);
+        EXPECT_THROWS_AS(e.emplace_right(bad), std::runtime_error);
+        EXPECT(e.as_left() == "keep");
+
+        // Replacing a value with one of the same alternative is covered too.
+        ben::either<counted<false>, int> same = counted<false>(3);
+        const counted<false> worse(-2);
+        EXPECT_THROWS_AS(same.emplace_left(worse), std::runtime_error);
+        EXPECT(same.as_left().v_ == 3);
+    }
+    EXPECT(counted<true>::live == 0);
+    EXPECT(counted<false>::live == 0);
+}
+
+CASE("lazy either evaluates once in place") {
+    int calls = 0;
+    auto make = [&calls] {
+        calls++;
+        return std::string(40, 'z');
+    };
+    ben::lazy_either<std::string, decltype(make)> lazy(make);
+    EXPECT(sizeof(lazy) == sizeof(ben::either<std::string, decltype(make)>));
+    EXPECT(!lazy.is_ready());
+    EXPECT(lazy.get().size() == 40u);
+    EXPECT(lazy->size() == 40u);
+    EXPECT(lazy.is_ready());
+    EXPECT(calls == 1);
+
+    ben::lazy_either<std::string, decltype(make)> ready(std::string("done"));
+    EXPECT(*ready == "done");
+    EXPECT(calls == 1);
+}
+
+CASE("lazy either retries after a throw") {
+    int calls = 0;
+    auto flaky = [&calls]() -> int {
+        if (calls++ == 0) {
+            throw std::runtime_error("not yet");
+        }
+        return 9;
+    };
+    ben::lazy_either<int, decltype(flaky)> lazy(flaky);
+    EXPECT_THROWS_AS(lazy.get(), std::runtime_error);
+    EXPECT(!lazy.is_ready());
+    EXPECT(lazy.get() == 9);
+    EXPECT(calls == 2);
+}
+
+CASE("lazy once runs the callable once across threads") {
+    std::atomic<int> calls{0};
+    auto make = [&calls] {
+        calls++;
+        return std::vector<int>(100, 1);
+    };
+    const ben::lazy_once<std::vector<int>, decltype(make)> lazy(make);
+    std::vector<std::thread> threads;
+    std::atomic<int> total{0};
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&] {
+            total += static_cast<int>(lazy.get().size());
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    EXPECT(calls == 1);
+    EXPECT(total == 400);
+    EXPECT(lazy.is_ready());
+}
+
+CASE("task result queues its continuation on completion") {
+    ben::local_executor ex;
+    ben::task_result<int, std::string> r(ex);
+    EXPECT(!r.is_ready());
+    int seen = 0;
+    ben::callback<std::function<void()>> cb([&] { seen = r.get().as_left(); });
+    r.then(cb);
+    r.set_value(42);
+    EXPECT(r.is_ready());
+    EXPECT(seen == 0);
+    EXPECT(ex.run() == 1u);
+    EXPECT(seen == 42);
+
+    // Waiting on a result that is already ready queues at once.
+    ben::task_result<int, std::string> failed(ex);
+    failed.set_error("bad");
+    std::string error;
+    ben::callback<std::function<void()>> on_error([&] { error = failed.get().as_right(); });
+    failed.then(on_error);
+    EXPECT(ex.run() == 1u);
+    EXPECT(error == "bad");
+}
+
+CASE("task result chains run iteratively") {
+    constexpr int depth = 10000;
+    ben::local_executor ex;
+    std::vector<std::unique_ptr<ben::task_result<int, std::string>>> results;
+    for (int i = 0; i <= depth; i++) {
+        results.emplace_back(new ben::task_result<int, std::string>(ex));
+    }
+    struct step {
+        std::vector<std::unique_ptr<ben::task_result<int, std::string>>>* results;
+        int i;
+        void operator()() const {
+            (*results)[i + 1]->set_value((*results)[i]->get().as_left() + 1);
+        }
+    };
+    std::vector<std::unique_ptr<ben::callback<step>>> steps;
+    for (int i = 0; i < depth; i++) {
+        steps.emplace_back(new ben::callback<step>(step{&results, i}));
+        results[i]->then(*steps.back());
+    }
+    results[0]->set_value(0);
+    EXPECT(ex.run() == static_cast<std::size_t>(depth));
+    EXPECT(results[depth]->get().as_left() == depth);
+}
+
+#if __cplusplus >= 202002L
+
+namespace {
+
+struct copy_counted_error {
+    explicit copy_counted_error(int* copies) : copies_(copies) {}
+    copy_counted_error(const copy_counted_error& other) : copies_(other.copies_) {
+        (*copies_)++;
+    }
+    copy_counted_error(copy_counted_error&&) = default;
+    copy_counted_error& operator=(const copy_counted_error& other) {
+        copies_ = other.copies_;
+        (*copies_)++;
+        return *this;
+    }
+    copy_counted_error& operator=(copy_counted_error&&) = default;
+
+    int* copies_;
+};
+
+using coro_result = ben::either<int, copy_counted_error>;
+
+coro_result coro_leaf(int v, int* copies) {
+    if (v < 0) {
+        return copy_counted_error{copies};
+    }
+    return v;
+}
+
+ben::co_either<int, copy_counted_error> coro_middle(int v, int* copies) {
+    int x = co_await coro_leaf(v, copies);
+    co_return x + 1;
+}
+
+ben::co_either<int, copy_counted_error> coro_top(int v, int* copies) {
+    int x = co_await coro_middle(v, copies);
+    int y = co_await coro_middle(x, copies);
+    co_return x + y;
+}
+
+} // namespace
+
+CASE("co_await yields the left value") {
+    int copies = 0;
+    coro_result r = coro_top(1, &copies);
+    EXPECT(r.is_left());
+    EXPECT(r.as_left() == 5);
+}
+
+CASE("co_await short circuits the right without copying") {
+    int copies = 0;
+    bool reached = false;
+    auto f = [&](int v) -> ben::co_either<int, copy_counted_error> {
+        int x = co_await coro_top(v, &copies);
+        reached = true;
+        co_return x;
+    };
+    coro_result r = f(-1);
+    EXPECT(r.is_right());
+    EXPECT_NOT(reached);
+    EXPECT(copies == 0);
+}
+
+CASE("co_await on an lvalue either") {
+    ben::either<std::string, int> err = 7;
+    ben::either<std::string, int> ok = std::string("fine");
+    auto f = [](const ben::either<std::string, int>& in) -> ben::co_either<size_t, long> {
+        const std::string& s = co_await in;
+        co_return s.size();
+    };
+    ben::either<size_t, long> a = f(ok);
+    ben::either<size_t, long> b = f(err);
+    EXPECT(a.is_left());
+    EXPECT(a.as_left() == 4u);
+    EXPECT(b.is_right());
+    EXPECT(b.as_right() == 7);
+    EXPECT(ok.as_left() == "fine");
+}
+
+CASE("co_either frames do not touch the heap") {
+    int copies = 0;
+    const size_t before = ben::detail::frame_pool::heap_allocations();
+    for (int i = 0; i < 1000; i++) {
+        coro_result r = coro_top(i % 7 - 3, &copies);
+        EXPECT(r.is_left() == (i % 7 - 3 >= 0));
+    }
+    EXPECT(ben::detail::frame_pool::heap_allocations() == before);
+}
+
+CASE("co_either rethrows exceptions") {
+    auto f = []() -> ben::co_either<int, char> {
+        throw std::runtime_error("boom");
+        co_return 1;
+    };
+    EXPECT_THROWS_AS(f().get(), std::runtime_error);
+}
+
+struct detached {
+    struct promise_type {
+        detached get_return_object() {
+            return {};
+        }
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() {
+            std::terminate();
+        }
+    };
+};
+
+detached await_sum(ben::task_result<int, std::string>& a, ben::task_result<int, std::string>& b, int* out) {
+    const int x = (co_await a).as_left();
+    const int y = (co_await b).as_left();
+    *out = x + y;
+}
+
+CASE("co_await a task result") {
+    ben::local_executor ex;
+    ben::task_result<int, std::string> a(ex);
+    ben::task_result<int, std::string> b(ex);
+    b.set_value(2);
+    int out = 0;
+    await_sum(a, b, &out);
+    EXPECT(out == 0);
+    a.set_value(40);
+    EXPECT(out == 0);
+    ex.run();
+    EXPECT(out == 42);
+}
+
+CASE("co_either awaits other awaitables as they are") {
+    ben::local_executor ex;
+    ben::task_result<int, std::string> ready(ex);
+    ready.set_value(41);
+    auto f = [](ben::task_result<int, std::string>& t) -> ben::co_either<int, std::string> {
+        ben::either<int, std::string>& r = co_await t;
+        int v = co_await r;
+        co_return v + 1;
+    };
+    ben::either<int, std::string> r = f(ready);
+    EXPECT(r.as_left() == 42);
+    ben::either_likely<int, std::string, ben::either_hint::left> likely = std::string("no");
+    auto g = [](ben::either_likely<int, std::string, ben::either_hint::left>& e) -> ben::co_either<int, std::string> {
+        co_return co_await e;
+    };
+    ben::either<int, std::string> no = g(likely);
+    EXPECT(no.as_right() == "no");
+}
+
+#endif // __cplusplus >= 202002L
+
+namespace {
+
+struct rich_error {
+    std::string message;
+    std::array<int, 16> context;
+
+    bool operator==(const rich_error& other) const {
+        return message == other.message && context == other.context;
+    }
+};
+
+} // namespace
+
+CASE("cold right is stored out of line") {
+    using cold_t = ben::either<int, ben::cold<rich_error>>;
+    EXPECT(sizeof(cold_t) <= 2 * sizeof(void*));
+    EXPECT(sizeof(cold_t) < sizeof(ben::either<int, rich_error>));
+
+    cold_t ok = 5;
+    EXPECT(ok.is_left());
+    EXPECT(ok.as_left() == 5);
+
+    cold_t err = rich_error{"disk on fire", {}};
+    EXPECT(err.is_right());
+    EXPECT(err.as_right().message == "disk on fire");
+    err.right_ref().context[3] = 9;
+
+    cold_t copy(err);
+    EXPECT(copy.is_right());
+    EXPECT(copy.as_right().context[3] == 9);
+    EXPECT(&copy.as_right() != &err.as_right());
+
+    const rich_error* before = &err.as_right();
+    cold_t moved(std::move(err));
+    EXPECT(&moved.as_right() == before);
+
+    moved = 12;
+    EXPECT(moved.is_left());
+    EXPECT(moved.as_left() == 12);
+    ok = copy;
+    EXPECT(ok.is_right());
+    EXPECT(ok.as_right().message == "disk on fire");
+    EXPECT(ok == copy);
+    EXPECT_NOT(ok == moved);
+
+    const rich_error* held = &ok.as_right();
+    swap(ok, moved);
+    EXPECT(ok.as_left() == 12);
+    EXPECT(&moved.as_right() == held);
+}
+
+CASE("cold right supports emplace and value_or") {
+    using cold_t = ben::either<std::string, ben::cold<rich_error>>;
+    static_assert(std::is_nothrow_move_constructible<cold_t>::value, "");
+    static_assert(std::is_nothrow_move_assignable<cold_t>::value, "");
+    static_assert(noexcept(std::declval<cold_t&>().swap(std::declval<cold_t&>())), "");
+
+    cold_t e = std::string("a");
+    EXPECT(e.emplace_left(3u, 'b') == "bbb");
+    EXPECT(std::move(e).value_or("x") == "bbb");
+    EXPECT(e.emplace_right(rich_error{"late", {}}).message == "late");
+    EXPECT(e.is_right());
+    EXPECT(e.value_or("fallback") == "fallback");
+    e.emplace_right(rich_error{"later", {}});
+    EXPECT(e.as_right().message == "later");
+    e.emplace_left("left");
+    EXPECT(e.as_left() == "left");
+}
+
+CASE("cold right destructor fires") {
+    int c = 0;
+    {
+        ben::either<int, ben::cold<destruct_counter>> e(destruct_counter{&c});
+        EXPECT(e.is_right());
+        ben::either<int, ben::cold<destruct_counter>> f(std::move(e));
+        EXPECT(c == 0);
+        e = 3;
+        EXPECT(c == 0);
+    }
+    EXPECT(c == 1);
+}
+
+CASE("cold either is usable after being moved from") {
+    using cold_t = ben::either<int, ben::cold<std::string>>;
+    cold_t e = std::string(40, 'e');
+    cold_t f(std::move(e));
+    EXPECT(e.is_left());
+    EXPECT(e.as_left() == 0);
+    EXPECT(f.as_right() == std::string(40, 'e'));
+    cold_t g = std::string("g");
+    g = std::move(f);
+    EXPECT(f.is_left());
+    EXPECT(f == e);
+    cold_t copy(f);
+    EXPECT(ben::visit(copy, [](int v) { return v; }, [](const std::string&) { return -1; }) == 0);
+
+    // With no nothrow default constructor for the left, the right is moved
+    // into a new block and the moved-from either keeps a right.
+    using kept_t = ben::either<throwing_move, ben::cold<std::string>>;
+    static_assert(!std::is_nothrow_move_constructible<kept_t>::value, "");
+    kept_t k = std::string(40, 'k');
+    kept_t m(std::move(k));
+    EXPECT(k.is_right());
+    EXPECT(m.as_right() == std::string(40, 'k'));
+    kept_t n = throwing_move(1);
+    n = std::move(m);
+    EXPECT(m.is_right());
+    EXPECT(n.as_right() == std::string(40, 'k'));
+    swap(k, n);
+    EXPECT(k.as_right() == std::string(40, 'k'));
+    EXPECT(kept_t(n).is_right());
+}
+
+CASE("cold either outlives its thread's pool") {
+    // e is built before the thread's pool cache and so destroyed after it.
+    bool held_right = false;
+    std::thread([&held_right] {
+        static thread_local ben::either<int, ben::cold<std::string>> e = 1;
+        e.emplace_right(40u, 'x');
+        held_right = e.is_right();
+    }).join();
+    EXPECT(held_right);
+}
+
+CASE("trivially relocatable trait") {
+    using slow_t = std::unique_ptr<char[]>;
+    using fast_t = std::array<char, 10>;
+    EXPECT((ben::is_trivially_relocatable<ben::either<int, char>>::value));
+    EXPECT((ben::is_trivially_relocatable<ben::either<slow_t, fast_t>>::value));
+    EXPECT((ben::is_trivially_relocatable<ben::either<int, ben::cold<std::string>>>::value));
+    EXPECT_NOT((ben::is_trivially_relocatable<ben::either<std::string, int>>::value));
+    EXPECT_NOT((ben::is_trivially_relocatable<ben::either<destruct_counter, int>>::value));
+}
+
+CASE("uninitialized relocate") {
+    constexpr size_t size = 10;
+    using slow_t = std::unique_ptr<char[]>;
+    using fast_t = std::array<char, size>;
+    using either_t = ben::either<slow_t, fast_t>;
+    constexpr size_t n = 8;
+
+    alignas(either_t) unsigned char src_buf[n * sizeof(either_t)];
+    alignas(either_t) unsigned char dst_buf[n * sizeof(either_t)];
+    either_t* src = reinterpret_cast<either_t*>(src_buf);
+    either_t* dst = reinterpret_cast<either_t*>(dst_buf);
+    std::vector<const char*> ptrs;
+    for (size_t i = 0; i < n; i++) {
+        if (i % 2 == 0) {
+            new (&src[i]) either_t(std::make_unique<char[]>(size));
+            ptrs.push_back(src[i].as_left().get());
+        } else {
+            new (&src[i]) either_t(fast_t{{'a', 'b'}});
+            ptrs.push_back(nullptr);
+        }
+    }
+    either_t* end = ben::uninitialized_relocate(src, src + n, dst);
+    EXPECT(end == dst + n);
+    for (size_t i = 0; i < n; i++) {
+        if (i % 2 == 0) {
+            EXPECT(dst[i].is_left());
+            EXPECT(dst[i].as_left().get() == ptrs[i]);
+        } else {
+            EXPECT(dst[i].is_right());
+            EXPECT(dst[i].as_right()[1] == 'b');
+        }
+        dst[i].~either_t();
+    }
+}
+
+CASE("uninitialized relocate without trivial relocation") {
+    int c = 0;
+    using either_t = ben::either<destruct_counter, std::string>;
+    alignas(either_t) unsigned char src_buf[2 * sizeof(either_t)];
+    alignas(either_t) unsigned char dst_buf[2 * sizeof(either_t)];
+    either_t* src = reinterpret_cast<either_t*>(src_buf);
+    either_t* dst = reinterpret_cast<either_t*>(dst_buf);
+    new (&src[0]) either_t(destruct_counter{&c});
+    new (&src[1]) either_t(std::string("a string too long for small string storage"));
+    ben::uninitialized_relocate(src, src + 2, dst);
+    EXPECT(c == 0);
+    EXPECT(dst[0].is_left());
+    EXPECT(dst[1].as_right() == "a string too long for small string storage");
+    dst[0].~either_t();
+    dst[1].~either_t();
+    EXPECT(c == 1);
+}
+
+namespace {
+
+constexpr ben::either<int, char> constexpr_table[] = {1, 'b', 3};
+
+constexpr int constexpr_assign() {
+    ben::either<int, char> e = 1;
+    e = 'x';
+    ben::either<int, char> f = e;
+    f = 5;
+    e = f;
+    return e.as_left() + (f == e ? 10 : 0);
+}
+
+} // namespace
+
+CASE("constexpr either of literal types") {
+    static_assert(std::is_trivially_destructible<ben::either<int, char>>::value, "");
+    static_assert(std::is_trivially_copyable<ben::either<int, char>>::value, "");
+    static_assert(constexpr_table[0].is_left(), "");
+    static_assert(constexpr_table[1].as_right() == 'b', "");
+    static_assert(constexpr_table[2] == ben::either<int, char>(3), "");
+    static_assert(constexpr_assign() == 15, "");
+    EXPECT(constexpr_table[2].as_left() == 3);
+}
+
+#if __cplusplus >= 202002L
+
+namespace {
+
+constexpr size_t constexpr_non_trivial() {
+    ben::either<std::string, int> e = std::string("hi");
+    e = 3;
+    ben::either<std::string, int> f = e;
+    e = std::string("abc");
+    f = std::move(e);
+    ben::either<std::string, int> g(f);
+    return g.as_left().size() + (f == g ? 10 : 0);
+}
+
+} // namespace
+
+CASE("constexpr either of non-trivial types") {
+    static_assert(constexpr_non_trivial() == 13);
+    EXPECT(constexpr_non_trivial() == 13u);
+}
+
+#endif // __cplusplus >= 202002L
+
+namespace {
+
+struct tree_leaf {
+    int value;
+};
+
+struct tree_node {
+    explicit tree_node(int* destroyed) : destroyed_(destroyed) {}
+    ~tree_node() {
+        (*destroyed_)++;
+    }
+    int* destroyed_;
+};
+
+// Trees whose nodes name themselves while still incomplete.
+struct linked_node {
+    ben::ptr_either<linked_node*, tree_leaf*> next;
+};
+
+struct owning_node {
+    ben::ptr_either<std::unique_ptr<owning_node>, std::unique_ptr<tree_leaf>> child;
+};
+
+} // namespace
+
+CASE("ptr either of an incomplete pointee") {
+    tree_leaf leaf{3};
+    linked_node tail{&leaf};
+    linked_node head{&tail};
+    EXPECT(head.next.is_left());
+    EXPECT(head.next.as_left()->next.as_right()->value == 3);
+
+    owning_node root{std::make_unique<owning_node>(owning_node{std::make_unique<tree_leaf>(tree_leaf{7})})};
+    EXPECT(root.child.as_left()->child.as_right()->value == 7);
+}
+
+CASE("ptr either of raw pointers") {
+    using either_t = ben::ptr_either<tree_leaf*, tree_node*>;
+    static_assert(sizeof(either_t) == sizeof(void*), "tag must share the pointer word");
+    static_assert(std::is_trivially_copyable<either_t>::value, "raw pointers need no ownership");
+
+    tree_leaf leaf{4};
+    int destroyed = 0;
+    tree_node node(&destroyed);
+
+    either_t e = &leaf;
+    EXPECT(e.is_left());
+    EXPECT(e.as_left() == &leaf);
+    EXPECT(e.as_left()->value == 4);
+    e.left_ref()->value = 5;
+    EXPECT(leaf.value == 5);
+
+    either_t f = e;
+    EXPECT(f == e);
+    f = &node;
+    EXPECT(f.is_right());
+    EXPECT(f.as_right() == &node);
+    EXPECT_NOT(f == e);
+
+    f.right_ref() = nullptr;
+    EXPECT(f.is_right());
+    EXPECT(f.as_right() == nullptr);
+    EXPECT(destroyed == 0);
+}
+
+CASE("ptr either of unique pointers") {
+    using either_t = ben::ptr_either<std::unique_ptr<tree_leaf>, std::unique_ptr<tree_node>>;
+    static_assert(sizeof(either_t) == sizeof(void*), "tag must share the pointer word");
+    int destroyed = 0;
+    {
+        either_t e = std::make_unique<tree_node>(&destroyed);
+        EXPECT(e.is_right());
+        EXPECT(e.as_right().get() != nullptr);
+        EXPECT(e.as_right()->destroyed_ == &destroyed);
+
+        either_t f(std::move(e));
+        EXPECT(f.is_right());
+        EXPECT(e.is_right());
+        EXPECT(e.as_right().get() == nullptr);
+        EXPECT(destroyed == 0);
+
+        f = std::make_unique<tree_leaf>(tree_leaf{9});
+        EXPECT(destroyed == 1);
+        EXPECT(f.is_left());
+        EXPECT(f.as_left()->value == 9);
+
+        f = std::make_unique<tree_node>(&destroyed);
+        std::unique_ptr<tree_node> taken = f.take_right();
+        EXPECT(f.as_right().get() == nullptr);
+        EXPECT(destroyed == 1);
+        taken.reset();
+        EXPECT(destroyed == 2);
+
+        f.right_ref().reset(new tree_node(&destroyed));
+        EXPECT(destroyed == 2);
+    }
+    EXPECT(destroyed == 3);
+}
+
+CASE("nan boxed either") {
+    using either_t = ben::nan_either<double, uint32_t>;
+    static_assert(sizeof(either_t) == 8, "nan boxing must fit one word");
+    EXPECT(sizeof(either_t) < sizeof(ben::either<double, uint32_t>));
+
+    either_t e = 2.5;
+    EXPECT(e.is_left());
+    EXPECT(e.as_left() == 2.5);
+    e = uint32_t{0xdeadbeef};
+    EXPECT(e.is_right());
+    EXPECT(e.as_right() == 0xdeadbeef);
+    e = -HUGE_VAL;
+    EXPECT(e.is_left());
+    EXPECT(e.as_left() == -HUGE_VAL);
+    e = -std::nan("7");
+    EXPECT(e.is_left());
+    EXPECT(std::isnan(e.as_left()));
+    EXPECT(e.bits() == 0x7ff8000000000000ull);
+    EXPECT(either_t(0.0) == either_t(-0.0));
+    EXPECT_NOT(either_t(0.0) == either_t(uint32_t{0}));
+    EXPECT(either_t(uint32_t{3}) == either_t(uint32_t{3}));
+}
+
+CASE("nan boxed either of pointers") {
+    int x = 1;
+    ben::nan_either<double, int*> e = &x;
+    EXPECT(e.is_right());
+    EXPECT(e.as_right() == &x);
+    e = 1e300;
+    EXPECT(e.is_left());
+    EXPECT(e.as_left() == 1e300);
+}
+
+CASE("nan boxed bulk operations") {
+    using either_t = ben::nan_either<double, uint32_t>;
+    const double in[] = {1.0, 2.0, 3.0, 4.0, 5.0};
+    std::vector<either_t> v(5, either_t(0.0));
+    ben::box_doubles(in, 5, v.data());
+    v[1] = uint32_t{7};
+    v[3] = uint32_t{8};
+    EXPECT(ben::count_left(v.data(), v.size()) == 3u);
+    EXPECT(ben::sum_left(v.data(), v.size()) == 9.0);
+    double out[5];
+    ben::unbox_lefts(v.data(), v.size(), out, -1.0);
+    EXPECT(out[0] == 1.0);
+    EXPECT(out[1] == -1.0);
+    EXPECT(out[4] == 5.0);
+}
+
+CASE("either of references") {
+    int a = 1;
+    int b = 2;
+    std::string s = "x";
+    ben::either<int&, std::string&> e = a;
+    EXPECT(sizeof(e) == sizeof(void*));
+    EXPECT(e.is_left());
+    EXPECT(&e.as_left() == &a);
+    e.left_ref() = 5;
+    EXPECT(a == 5);
+    // Assignment rebinds instead of writing through.
+    e = b;
+    EXPECT(&e.as_left() == &b);
+    EXPECT(a == 5);
+    e = s;
+    EXPECT(e.is_right());
+    e.right_ref() += "y";
+    EXPECT(s == "xy");
+    using ref_either = ben::either<int&, std::string&>;
+    std::string t = "xy";
+    EXPECT(e == ref_either(t));
+    EXPECT(!(e == ref_either(b)));
+    static_assert(std::is_trivially_copyable<ref_either>::value, "");
+    static_assert(!std::is_constructible<ref_either, int>::value, "");
+    static_assert(ben::is_trivially_relocatable<ref_either>::value, "");
+}
+
+CASE("either of references to unaligned types") {
+    char c = 'c';
+    int i = 3;
+    ben::either<char&, int&> e = c;
+    EXPECT(sizeof(e) > sizeof(void*));
+    EXPECT(e.is_left());
+    EXPECT(static_cast<void*>(&e.as_left()) == static_cast<void*>(&c));
+    e = i;
+    EXPECT(e.is_right());
+    EXPECT(&e.as_right() == &i);
+}
+
+#if __cplusplus >= 201703L
+CASE("cow borrows until mutated") {
+    const std::string input = "hello";
+    ben::cow<std::string> c(std::string_view{input});
+    EXPECT(c.is_borrowed());
+    EXPECT(c.data() == input.data());
+    EXPECT(c.view() == "hello");
+    c.to_mut() += " world";
+    EXPECT(c.is_owned());
+    EXPECT(c.view() == "hello world");
+    EXPECT(input == "hello");
+    EXPECT(std::move(c).into_owned() == "hello world");
+}
+
+CASE("cow compares the viewed data") {
+    const std::vector<char> buffer = {'a', 'b'};
+    ben::cow<std::vector<char>> borrowed(ben::buffer_view<char>{buffer});
+    ben::cow<std::vector<char>> owned(std::vector<char>{'a', 'b'});
+    EXPECT(borrowed.is_borrowed());
+    EXPECT(owned.is_owned());
+    EXPECT(borrowed == owned);
+    owned.to_mut().push_back('c');
+    EXPECT(!(borrowed == owned));
+    EXPECT(owned.size() == 3u);
+}
+
+CASE("cow borrows literals and owns only when asked") {
+    static_assert(!std::is_convertible<std::string, ben::cow<std::string>>::value, "");
+    static_assert(!std::is_convertible<const std::string&, ben::cow<std::string>>::value, "");
+    static_assert(std::is_convertible<std::string_view, ben::cow<std::string>>::value, "");
+    static_assert(!std::is_constructible<ben::cow<std::vector<char>>, const char*>::value, "");
+    const char* text = "literal";
+    ben::cow<std::string> lit("literal");
+    ben::cow<std::string> ptr(text);
+    EXPECT(lit.is_borrowed());
+    EXPECT(ptr.is_borrowed());
+    EXPECT(ptr.data() == text);
+    EXPECT(lit == ptr);
+    const std::string s = "kept";
+    ben::cow<std::string> copy(s);
+    EXPECT(copy.is_owned());
+    EXPECT(copy.data() != s.data());
+}
+
+struct fails_to_build {
+    explicit fails_to_build(int) {
+        throw std::runtime_error("fails_to_build");
+    }
+    std::string s;
+};
+
+CASE("variant and optional conversions") {
+    using result = ben::either<std::string, int>;
+    result l = std::string(64, 'x');
+    const char* data = l.as_left().data();
+    std::variant<std::string, int> v = ben::to_variant(std::move(l));
+    EXPECT(v.index() == 0u);
+    EXPECT(std::get<0>(v).data() == data);
+    result back = ben::from_variant(std::move(v));
+    EXPECT(back.as_left().data() == data);
+
+    const result r = 3;
+    EXPECT(std::get<1>(ben::to_variant(r)) == 3);
+    EXPECT(ben::from_variant(ben::to_variant(r)) == r);
+
+    EXPECT(*ben::to_optional(back) == std::string(64, 'x'));
+    EXPECT(!ben::to_optional(r).has_value());
+    EXPECT(ben::from_optional<int>(std::optional<std::string>("a"), 0).as_left() == "a");
+    EXPECT(ben::from_optional<int>(std::optional<std::string>(), 7).as_right() == 7);
+
+    std::variant<std::string, fails_to_build> valueless;
+    EXPECT_THROWS(valueless.emplace<1>(0));
+    EXPECT(valueless.valueless_by_exception());
+    EXPECT_THROWS_AS(ben::from_variant(valueless), std::bad_variant_access);
+    EXPECT_THROWS_AS(ben::from_variant(std::move(valueless)), std::bad_variant_access);
+}
+
+CASE("arena batch allocates from the arena") {
+    ben::arena_batch<std::pmr::string, std::pmr::vector<char>> batch;
+    static_assert(decltype(batch)::disposable, "");
+    for (int i = 0; i < 100; i++) {
+        if (i % 2 == 0) {
+            batch.emplace_left(40u, static_cast<char>('a' + i % 26));
+        } else {
+            batch.emplace_right(std::size_t(i), 'v');
+        }
+    }
+    EXPECT(batch.size() == 100u);
+    EXPECT(batch[0].as_left() == std::string_view(std::string(40, 'a')));
+    EXPECT(batch[0].as_left().get_allocator().resource() == batch.resource());
+    EXPECT(batch[99].as_right().size() == 99u);
+    EXPECT(batch[99].as_right().get_allocator().resource() == batch.resource());
+    batch.clear();
+    EXPECT(batch.empty());
+    batch.emplace_left("again");
+    EXPECT(batch[0].as_left() == "again");
+    batch.assign_right(0, 50u, 'w');
+    EXPECT(batch[0].as_right().size() == 50u);
+    EXPECT(batch[0].as_right().get_allocator().resource() == batch.resource());
+}
+
+CASE("arena batch destroys elements that are not disposable") {
+    int destroyed = 0;
+    {
+        ben::arena_batch<int, destruct_counter> batch;
+        static_assert(!decltype(batch)::disposable, "");
+        batch.reserve(11);
+        for (int i = 0; i < 10; i++) {
+            batch.emplace_right(&destroyed);
+        }
+        batch.emplace_left(1);
+        EXPECT(destroyed == 0);
+    }
+    EXPECT(destroyed == 10);
+}
+
+struct copy_limited {
+    static int live;
+    static int copies_left;
+
+    copy_limited(int v) : v_(v) {
+        live++;
+    }
+    copy_limited(const copy_limited& other) : v_(other.v_) {
+        if (copies_left-- == 0) {
+            throw std::runtime_error("copy_limited");
+        }
+        live++;
+    }
+    copy_limited(copy_limited&& other) noexcept(false) : v_(other.v_) {
+        live++;
+    }
+    ~copy_limited() {
+        live--;
+    }
+    int v_;
+};
+
+int copy_limited::live = 0;
+int copy_limited::copies_left = 0;
+
+CASE("arena batch keeps its elements when growing throws") {
+    {
+        ben::arena_batch<copy_limited, int> batch;
+        batch.reserve(4);
+        for (int i = 0; i < 4; i++) {
+            batch.emplace_left(i);
+        }
+        copy_limited::copies_left = 2;
+        EXPECT_THROWS(batch.emplace_left(4));
+        EXPECT(batch.size() == 4u);
+        EXPECT(copy_limited::live == 4);
+        for (int i = 0; i < 4; i++) {
+            EXPECT(batch[i].as_left().v_ == i);
+        }
+        copy_limited::copies_left = 4;
+        batch.emplace_left(4);
+        EXPECT(batch.size() == 5u);
+        EXPECT(batch[4].as_left().v_ == 4);
+    }
+    EXPECT(copy_limited::live == 0);
+}
+
+CASE("either array pads each element to its own slot") {
+    ben::either_array<long, std::string, ben::cache_line_size> arr(4, ben::either<long, std::string>(0L));
+    EXPECT(arr.size() == 4u);
+    EXPECT(reinterpret_cast<std::uintptr_t>(&arr[0]) % ben::cache_line_size == 0u);
+    EXPECT(reinterpret_cast<const char*>(&arr[1]) - reinterpret_cast<const char*>(&arr[0]) ==
+           static_cast<std::ptrdiff_t>(ben::cache_line_size));
+    arr.left(1) = 7;
+    arr.emplace_right(2, "failed");
+    EXPECT(arr.is_left(1));
+    EXPECT(arr[1].as_left() == 7);
+    EXPECT(arr.is_right(2));
+    EXPECT(arr.right(2) == "failed");
+    EXPECT(arr.get(2) == (ben::either<long, std::string>(std::string("failed"))));
+    arr.emplace_left(2, 3L);
+    EXPECT(arr.left(2) == 3);
+
+    ben::either_array<int, char> packed(3, ben::either<int, char>('x'));
+    EXPECT(reinterpret_cast<const char*>(&packed[1]) - reinterpret_cast<const char*>(&packed[0]) ==
+           static_cast<std::ptrdiff_t>(sizeof(ben::either<int, char>)));
+}
+
+CASE("either array with a cold side table") {
+    using either_t = ben::either<long, std::string>;
+    ben::either_array<long, std::string, alignof(long), ben::either_split::cold_right> arr(3, either_t(std::string("e")));
+    EXPECT(arr.is_right(0));
+    EXPECT(arr.right(2) == "e");
+    arr.emplace_left(1, 5L);
+    EXPECT(arr.is_left(1));
+    EXPECT(arr.left(1) == 5);
+    EXPECT(arr.get(1) == either_t(5L));
+    arr.emplace_right(1, 4u, 'z');
+    EXPECT(arr.right(1) == "zzzz");
+    arr.emplace_right(1, "again");
+    EXPECT(arr.get(1) == either_t(std::string("again")));
+
+    const auto token = std::make_shared<int>(0);
+    {
+        ben::either_array<int, std::shared_ptr<int>, alignof(int), ben::either_split::cold_right> counted(
+            4, ben::either<int, std::shared_ptr<int>>(0));
+        for (std::size_t i = 0; i < 3; i++) {
+            counted.emplace_right(i, token);
+        }
+        EXPECT(token.use_count() == 4);
+        counted.emplace_left(0, 1);
+        EXPECT(token.use_count() == 3);
+    }
+    EXPECT(token.use_count() == 1);
+}
+
+CASE("either array emplace keeps the old value on a throw") {
+    {
+        using either_t = ben::either<counted<false>, std::string>;
+        ben::either_array<counted<false>, std::string, alignof(std::string), ben::either_split::cold_right> arr(
+            2, either_t(std::string("keep")));
+        arr.emplace_left(1, 1);
+        const counted<false> bad(-1);
+        EXPECT_THROWS_AS(arr.emplace_left(0, bad), std::runtime_error);
+        EXPECT(arr.right(0) == "keep");
+        EXPECT_THROWS_AS(arr.emplace_left(1, bad), std::runtime_error);
+        EXPECT(arr.left(1).v_ == 1);
+    }
+    EXPECT(counted<false>::live == 0);
+
+    // Alternatives whose moves may throw are fine too.
+    {
+        using either_t = ben::either<counted<true>, std::string>;
+        ben::either_array<counted<true>, std::string, alignof(std::string), ben::either_split::cold_right> arr(
+            1, either_t(std::string("keep")));
+        const counted<true> bad(-1);
+        EXPECT_THROWS_AS(arr.emplace_left(0, bad), std::runtime_error);
+        EXPECT(arr.right(0) == "keep");
+        arr.emplace_left(0, 2);
+        EXPECT(arr.left(0).v_ == 2);
+    }
+    EXPECT(counted<true>::live == 0);
+}
+
+CASE("either array slots updated from several threads") {
+    constexpr std::size_t threads = 4;
+    ben::either_array<std::uint64_t, std::string, ben::cache_line_size, ben::either_split::cold_right> arr(
+        threads, ben::either<std::uint64_t, std::string>(std::uint64_t{0}));
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&arr, t] {
+            for (int i = 0; i < 10000; i++) {
+                arr.left(t)++;
+            }
+            if (t == 3) {
+                arr.emplace_right(t, "done");
+            }
+        });
+    }
+    for (std::thread& w : workers) {
+        w.join();
+    }
+    for (std::size_t t = 0; t < 3; t++) {
+        EXPECT(arr.left(t) == 10000u);
+    }
+    EXPECT(arr.right(3) == "done");
+}
+
+#if defined(__cpp_lib_expected)
+CASE("expected conversions") {
+    using result = ben::either<std::string, int>;
+    const result l = std::string("ok");
+    const result r = 5;
+    EXPECT(*ben::to_expected(l) == "ok");
+    EXPECT(ben::to_expected(r).error() == 5);
+    EXPECT(ben::from_expected(ben::to_expected(l)) == l);
+    EXPECT(ben::from_expected(ben::to_expected(r)) == r);
+}
+#endif // __cpp_lib_expected
+#endif // __cplusplus >= 201703L
+
+CASE("either layout") {
+    using large = std::array<int, 500>;
+    using small = std::array<int, 256>;
+    using big = ben::either_layout<large, small>;
+    static_assert(big::size == sizeof(ben::either<large, small>), "");
+    static_assert(big::payload_size == sizeof(large), "");
+    static_assert(big::tag_size == 1 && big::payload_offset == alignof(int), "");
+    static_assert(big::padding == alignof(int) - 1, "");
+    static_assert(!big::uses_niche, "");
+
+    using wide = ben::either_layout<std::uint64_t, std::uint8_t>;
+    static_assert(wide::size == 16 && wide::padding == 7, "");
+    static_assert(!ben::is_size_optimal<std::uint64_t, std::uint8_t>::value, "");
+    static_assert(ben::is_size_optimal<char, std::array<char, 7>>::value, "");
+
+    using refs = ben::either_layout<int&, std::string&>;
+    static_assert(refs::uses_niche && refs::tag_size == 0 && refs::size == sizeof(void*), "");
+    static_assert(ben::is_size_optimal<int&, std::string&>::value, "");
+    static_assert(!ben::either_layout<char&, int&>::uses_niche, "");
+
+    using cold = ben::either_layout<int, ben::cold<std::array<char, 100>>>;
+    static_assert(cold::payload_size == sizeof(void*) && cold::padding == alignof(void*) - 1, "");
+
+    char line[160] = {};
+    std::FILE* out = std::tmpfile();
+    ben::write_either_layout<std::uint64_t, std::uint8_t>(out, "either<uint64_t, uint8_t>");
+    std::rewind(out);
+    EXPECT(std::fgets(line, sizeof(line), out) != nullptr);
+    std::fclose(out);
+    EXPECT(std::strstr(line, "size  16") != nullptr);
+    EXPECT(std::strstr(line, "padding   7") != nullptr);
+    EXPECT(std::strstr(line, "optimal") == nullptr);
+}
+
+CASE("packed either is byte aligned") {
+    using packed = ben::packed_either<std::uint8_t, std::uint64_t>;
+    static_assert(sizeof(packed) == 9 && alignof(packed) == 1, "");
+    packed p(std::uint64_t{0x0102030405060708});
+    EXPECT(p.is_right());
+    EXPECT(p.right() == 0x0102030405060708u);
+    p.set_left(7);
+    EXPECT(p.is_left());
+    EXPECT(p.left() == 7);
+    EXPECT(p == packed(std::uint8_t{7}));
+    const packed fresh(std::uint8_t{7});
+    EXPECT(std::memcmp(&p, &fresh, sizeof(packed)) == 0);
+    EXPECT(p.to_either() == (ben::either<std::uint8_t, std::uint64_t>(std::uint8_t{7})));
+    EXPECT(packed(p.to_either()) == p);
+}
+
+template <typename L, typename R>
+bool unpack_round_trips(L left_value, R right_value) {
+    std::vector<ben::either<L, R>> src;
+    for (int i = 0; i < 37; i++) {
+        if (i % 3 == 0) {
+            src.emplace_back(static_cast<L>(left_value + i));
+        } else {
+            src.emplace_back(static_cast<R>(right_value * (i + 1)));
+        }
+    }
+    std::vector<ben::packed_either<L, R>> packed(src.size(), ben::packed_either<L, R>(left_value));
+    ben::pack(src.data(), src.size(), packed.data());
+    std::vector<ben::either<L, R>> dst(src.size(), ben::either<L, R>(right_value));
+    ben::unpack(packed.data(), packed.size(), dst.data());
+    return src == dst;
+}
+
+CASE("unpack packed eithers") {
+    static_assert(ben::detail::can_unpack_sse2<std::uint8_t, std::uint64_t>::value, "");
+    static_assert(!ben::detail::can_unpack_sse2<std::uint8_t, std::uint32_t>::value, "");
+    EXPECT((unpack_round_trips<std::uint8_t, std::uint64_t>(3, 0x1122334455667788u)));
+    EXPECT((unpack_round_trips<std::uint8_t, std::uint32_t>(3, 0x11223344u)));
+    EXPECT((unpack_round_trips<double, std::int16_t>(0.5, -3)));
+}
+
 int main(int argc, char* argv[]) {
     return lest::run(specification, argc, argv);
 }